@@ -1,4 +1,5 @@
 import os
+import json
 import subprocess
 import logging
 from collections import OrderedDict
@@ -98,6 +99,7 @@ def result_convert(thread_results, subtest_list, subtest_info):
                 subtest_values.append({
                     'thread': thread,
                     'value': value,
+                    'record': thread_result['records'][subtest],
                 })
             if thread_result['thread'] == all_cpu:
                 all_value = value
@@ -163,31 +165,48 @@ def get_system_info():
         ('distro', distro),
     ])
 
-def run_testcmd(testcmd):
+# xb-* tools run with -o json print one object per test case and line,
+# with a -T list every case record carries its thread count,
+# and the sweep summary of a case follows the records of all thread counts
+def run_sweep_testcmd(testcmd, thread_list):
     proc = popen(testcmd)
-    row = {}
+    rows = {nthread: {'thread': nthread, 'records': {}} for nthread in thread_list}
+    sweeps = {}
     for line in proc.stdout:
-        splited = line.decode().split()
-        name = splited[0]
-        value = float(splited[1])
-        row[name] = value
+        record = json.loads(line.decode())
+        name = record['name']
+        if 'sweep' in record:
+            sweeps[name] = record
+            continue
+        if 'load' in record:
+            # open-loop summary, its records are kept under name@rate
+            continue
+        if 'sizes' in record:
+            # working set sweep summary, its records are kept under name/size
+            continue
+        if 'matrix' in record:
+            # matrix summary, its cells are kept as separate records
+            continue
+        row = rows[record['results'][0]['threads']]
+        row[name] = record['rate']
+        row['records'][name] = record
     proc.wait()
-    return row
+    return [rows[nthread] for nthread in thread_list], sweeps
 
 def run_multithread_test(name, testcmd_tmpl, subtest_list, subtest_info, score_factor):
     thread_list = get_nthread_list_to_test()
-    thread_results = []
     test_gb = get_suggested_memory_use_gb()
     if test_gb == 0:
         raise exception.SkipException("Not enough memory to run memtest")
 
-    for nthread in thread_list:
-        testcmd = testcmd_tmpl.replace("<THREAD>", str(nthread))
-        row = run_testcmd(testcmd)
-        row['thread'] = nthread
-        thread_results.append(row)
+    # one process sweeps all thread counts
+    testcmd = testcmd_tmpl.replace("<THREAD>", ','.join(str(nthread) for nthread in thread_list))
+    thread_results, sweeps = run_sweep_testcmd(testcmd, thread_list)
 
     result = result_convert(thread_results, subtest_list, subtest_info)
+    for subtest_result in result:
+        if subtest_result['name'] in sweeps:
+            subtest_result['scaling'] = sweeps[subtest_result['name']]
     score = weighted_average(result, subtest_info) * score_factor
     return OrderedDict([
         ('name', name),
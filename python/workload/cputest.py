@@ -25,5 +25,5 @@ class CpuTest:
             'FPMAT-CONV':   {'weight': 1},
         }
         score_factor = 4
-        cmdtest_tmpl = f"xb-cputest -T <THREAD> -t 1 -q " + ' '.join(subtest_list)
+        cmdtest_tmpl = f"xb-cputest -T <THREAD> -t 1 -q -o json " + ' '.join(subtest_list)
         return common.run_multithread_test('cputest', cmdtest_tmpl, subtest_list, subtest_info, score_factor)
@@ -21,5 +21,5 @@ class MemTest:
         }
         score_factor = 0.052
         test_gb = common.get_suggested_memory_use_gb()
-        cmdtest_tmpl = f"xb-memtest -G {test_gb} -T <THREAD> -t 1 -q " + ' '.join(subtest_list)
+        cmdtest_tmpl = f"xb-memtest -G {test_gb} -T <THREAD> -t 1 -q -o json " + ' '.join(subtest_list)
         return common.run_multithread_test('memtest', cmdtest_tmpl, subtest_list, subtest_info, score_factor)
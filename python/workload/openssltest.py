@@ -22,5 +22,5 @@ class OpensslTest:
             'SM3-8K':       {'weight': 1},
         }
         score_factor = 0.003
-        cmdtest_tmpl = f"xb-openssl -T <THREAD> -t 1 -q " + ' '.join(subtest_list)
+        cmdtest_tmpl = f"xb-openssl -T <THREAD> -t 1 -q -o json " + ' '.join(subtest_list)
         return common.run_multithread_test('openssl', cmdtest_tmpl, subtest_list, subtest_info, score_factor)
@@ -0,0 +1,24 @@
+#ifndef __cputest_cases_h__
+#define __cputest_cases_h__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "multitask.h"
+
+struct cpu_case
+{
+    const char *name;
+    struct mt_test_ops *ops;
+    const uintptr_t *userdata;              // copied to mt_shared.userdata
+    size_t userdata_count;
+};
+
+// compute cases of xb-cputest in default run order, return the count, xb-memtest links
+// them too so one mixed case can pair a bandwidth tenant with a compute tenant
+size_t cpu_cases(const struct cpu_case **list);
+// case insensitive, NULL if name is not a compute case
+const struct cpu_case *cpu_case_lookup(const char *name);
+// fill ops and userdata of a mixed run group
+void cpu_case_group(const struct cpu_case *c, struct mt_group *group);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stddef.h>
+#include "cputest-sync.h"
+
+// 锁的实现放在单独的文件中, 函数调用同时充当编译器屏障,
+// 临界区内对共享数据的普通读写不会被移出加锁与解锁之间
+
+void spin_lock_acquire(struct spin_lock *lock)
+{
+    while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED))
+        {
+            mt_cpu_relax();
+        }
+    }
+}
+
+void spin_lock_release(struct spin_lock *lock)
+{
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+void ticket_lock_acquire(struct ticket_lock *lock)
+{
+    uint32_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&lock->serving, __ATOMIC_ACQUIRE) != ticket)
+    {
+        mt_cpu_relax();
+    }
+}
+
+void ticket_lock_release(struct ticket_lock *lock)
+{
+    // only the holder writes serving
+    uint32_t serving = __atomic_load_n(&lock->serving, __ATOMIC_RELAXED);
+    __atomic_store_n(&lock->serving, serving + 1, __ATOMIC_RELEASE);
+}
+
+void mcs_lock_acquire(struct mcs_lock *lock, struct mcs_node *node)
+{
+    struct mcs_node *prev;
+
+    node->next = NULL;
+    __atomic_store_n(&node->locked, 1, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (!prev)
+    {
+        return;
+    }
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE))
+    {
+        mt_cpu_relax();
+    }
+}
+
+void mcs_lock_release(struct mcs_lock *lock, struct mcs_node *node)
+{
+    struct mcs_node *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+
+    if (!next)
+    {
+        struct mcs_node *expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+        // a successor swapped the tail but has not linked itself yet
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)))
+        {
+            mt_cpu_relax();
+        }
+    }
+    __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,40 @@
+#ifndef __cputest_sync_h__
+#define __cputest_sync_h__
+
+#include <stdint.h>
+#include "multitask.h"
+
+// test and test-and-set spinlock, waiters spin on a plain load until the lock looks free
+struct spin_lock
+{
+    uint32_t locked;
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
+
+// fair spinlock, tickets are served in the order they were taken
+struct ticket_lock
+{
+    uint32_t next;
+    uint32_t serving;
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
+
+// queue lock, every waiter spins on its own node instead of the shared lock word
+struct mcs_node
+{
+    struct mcs_node *next;
+    uint32_t locked;
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
+
+struct mcs_lock
+{
+    struct mcs_node *tail;
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
+
+void spin_lock_acquire(struct spin_lock *lock);
+void spin_lock_release(struct spin_lock *lock);
+void ticket_lock_acquire(struct ticket_lock *lock);
+void ticket_lock_release(struct ticket_lock *lock);
+// node is owned by the caller and must stay valid until release returns
+void mcs_lock_acquire(struct mcs_lock *lock, struct mcs_node *node);
+void mcs_lock_release(struct mcs_lock *lock, struct mcs_node *node);
+
+#endif
@@ -0,0 +1,271 @@
+#include <stdint.h>
+#include "memtest-simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define SIMD_PATTERN 0x7878787878787878ull
+// software prefetch runs this far ahead of the loads
+#define SIMD_PREFETCH_DISTANCE 1024
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// one kernel family per vector width, every iteration moves 4 vectors and a shorter tail
+// is left alone, target attributes compile each width without raising the build baseline
+
+#define SIMD_X86_KERNELS(isa, isa_name, vec, bytes, load, store, stream, set1, vor)         \
+__attribute__((target(isa_name))) static void load_##isa(void *memory, size_t size)         \
+{                                                                                           \
+    const uint8_t *p = (const uint8_t *)memory;                                             \
+    vec a = set1(0), b = set1(0), c = set1(0), d = set1(0);                                 \
+    volatile vec result;                                                                    \
+    for (size_t i = 0; i < size / (4 * bytes); i++, p += 4 * bytes)                         \
+    {                                                                                       \
+        a = vor(a, load((const vec *)p));                                                   \
+        b = vor(b, load((const vec *)(p + bytes)));                                         \
+        c = vor(c, load((const vec *)(p + 2 * bytes)));                                     \
+        d = vor(d, load((const vec *)(p + 3 * bytes)));                                     \
+    }                                                                                       \
+    result = vor(vor(a, b), vor(c, d));                                                     \
+    (void)result;                                                                           \
+}                                                                                           \
+__attribute__((target(isa_name))) static void load_##isa##_pf(void *memory, size_t size)    \
+{                                                                                           \
+    const uint8_t *p = (const uint8_t *)memory;                                             \
+    vec a = set1(0), b = set1(0), c = set1(0), d = set1(0);                                 \
+    volatile vec result;                                                                    \
+    for (size_t i = 0; i < size / (4 * bytes); i++, p += 4 * bytes)                         \
+    {                                                                                       \
+        for (size_t line = 0; line < 4 * bytes; line += 64)                                 \
+        {                                                                                   \
+            __builtin_prefetch(p + SIMD_PREFETCH_DISTANCE + line, 0, 3);                    \
+        }                                                                                   \
+        a = vor(a, load((const vec *)p));                                                   \
+        b = vor(b, load((const vec *)(p + bytes)));                                         \
+        c = vor(c, load((const vec *)(p + 2 * bytes)));                                     \
+        d = vor(d, load((const vec *)(p + 3 * bytes)));                                     \
+    }                                                                                       \
+    result = vor(vor(a, b), vor(c, d));                                                     \
+    (void)result;                                                                           \
+}                                                                                           \
+__attribute__((target(isa_name))) static void store_##isa(void *memory, size_t size)        \
+{                                                                                           \
+    uint8_t *p = (uint8_t *)memory;                                                         \
+    vec v = set1(SIMD_PATTERN);                                                             \
+    for (size_t i = 0; i < size / (4 * bytes); i++, p += 4 * bytes)                         \
+    {                                                                                       \
+        store((vec *)p, v);                                                                 \
+        store((vec *)(p + bytes), v);                                                       \
+        store((vec *)(p + 2 * bytes), v);                                                   \
+        store((vec *)(p + 3 * bytes), v);                                                   \
+    }                                                                                       \
+}                                                                                           \
+__attribute__((target(isa_name))) static void store_##isa##_nt(void *memory, size_t size)   \
+{                                                                                           \
+    uint8_t *p = (uint8_t *)memory;                                                         \
+    vec v = set1(SIMD_PATTERN);                                                             \
+    for (size_t i = 0; i < size / (4 * bytes); i++, p += 4 * bytes)                         \
+    {                                                                                       \
+        stream((vec *)p, v);                                                                \
+        stream((vec *)(p + bytes), v);                                                      \
+        stream((vec *)(p + 2 * bytes), v);                                                  \
+        stream((vec *)(p + 3 * bytes), v);                                                  \
+    }                                                                                       \
+    _mm_sfence();                                                                           \
+}                                                                                           \
+__attribute__((target(isa_name))) static void copy_##isa(void *memory, size_t size)         \
+{                                                                                           \
+    const uint8_t *src = (const uint8_t *)memory;                                           \
+    uint8_t *dst = (uint8_t *)memory + size / 2;                                            \
+    for (size_t i = 0; i < size / 2 / (4 * bytes); i++, src += 4 * bytes, dst += 4 * bytes) \
+    {                                                                                       \
+        store((vec *)dst, load((const vec *)src));                                          \
+        store((vec *)(dst + bytes), load((const vec *)(src + bytes)));                      \
+        store((vec *)(dst + 2 * bytes), load((const vec *)(src + 2 * bytes)));              \
+        store((vec *)(dst + 3 * bytes), load((const vec *)(src + 3 * bytes)));              \
+    }                                                                                       \
+}                                                                                           \
+__attribute__((target(isa_name))) static void copy_##isa##_nt(void *memory, size_t size)    \
+{                                                                                           \
+    const uint8_t *src = (const uint8_t *)memory;                                           \
+    uint8_t *dst = (uint8_t *)memory + size / 2;                                            \
+    for (size_t i = 0; i < size / 2 / (4 * bytes); i++, src += 4 * bytes, dst += 4 * bytes) \
+    {                                                                                       \
+        stream((vec *)dst, load((const vec *)src));                                         \
+        stream((vec *)(dst + bytes), load((const vec *)(src + bytes)));                     \
+        stream((vec *)(dst + 2 * bytes), load((const vec *)(src + 2 * bytes)));             \
+        stream((vec *)(dst + 3 * bytes), load((const vec *)(src + 3 * bytes)));             \
+    }                                                                                       \
+    _mm_sfence();                                                                           \
+}
+
+SIMD_X86_KERNELS(sse2, "sse2", __m128i, 16, _mm_load_si128, _mm_store_si128, _mm_stream_si128,
+                 _mm_set1_epi64x, _mm_or_si128)
+SIMD_X86_KERNELS(avx2, "avx2", __m256i, 32, _mm256_load_si256, _mm256_store_si256, _mm256_stream_si256,
+                 _mm256_set1_epi64x, _mm256_or_si256)
+SIMD_X86_KERNELS(avx512, "avx512f", __m512i, 64, _mm512_load_si512, _mm512_store_si512, _mm512_stream_si512,
+                 _mm512_set1_epi64, _mm512_or_si512)
+
+#define SIMD_FUNCTIONS(ISA, isa)                                                            \
+    {"LOAD-" ISA, load_##isa},                                                              \
+    {"LOAD-" ISA "-PF", load_##isa##_pf},                                                   \
+    {"STORE-" ISA, store_##isa},                                                            \
+    {"STORE-" ISA "-NT", store_##isa##_nt},                                                 \
+    {"COPY-" ISA, copy_##isa},                                                              \
+    {"COPY-" ISA "-NT", copy_##isa##_nt}
+
+static const struct test_function sse2_functions[] = {SIMD_FUNCTIONS("SSE2", sse2)};
+static const struct test_function avx2_functions[] = {SIMD_FUNCTIONS("AVX2", avx2)};
+static const struct test_function avx512_functions[] = {SIMD_FUNCTIONS("AVX512", avx512)};
+
+#elif defined(__aarch64__)
+
+static void load_neon(void *memory, size_t size)
+{
+    const uint64_t *p = (const uint64_t *)memory;
+    uint64x2_t a = vdupq_n_u64(0), b = vdupq_n_u64(0), c = vdupq_n_u64(0), d = vdupq_n_u64(0);
+    volatile uint64_t result;
+
+    for (size_t i = 0; i < size / 64; i++, p += 8)
+    {
+        a = vorrq_u64(a, vld1q_u64(p));
+        b = vorrq_u64(b, vld1q_u64(p + 2));
+        c = vorrq_u64(c, vld1q_u64(p + 4));
+        d = vorrq_u64(d, vld1q_u64(p + 6));
+    }
+    a = vorrq_u64(vorrq_u64(a, b), vorrq_u64(c, d));
+    result = vgetq_lane_u64(a, 0) | vgetq_lane_u64(a, 1);
+    (void)result;
+}
+
+static void load_neon_pf(void *memory, size_t size)
+{
+    const uint64_t *p = (const uint64_t *)memory;
+    uint64x2_t a = vdupq_n_u64(0), b = vdupq_n_u64(0), c = vdupq_n_u64(0), d = vdupq_n_u64(0);
+    volatile uint64_t result;
+
+    for (size_t i = 0; i < size / 64; i++, p += 8)
+    {
+        __builtin_prefetch((const uint8_t *)p + SIMD_PREFETCH_DISTANCE, 0, 3);
+        a = vorrq_u64(a, vld1q_u64(p));
+        b = vorrq_u64(b, vld1q_u64(p + 2));
+        c = vorrq_u64(c, vld1q_u64(p + 4));
+        d = vorrq_u64(d, vld1q_u64(p + 6));
+    }
+    a = vorrq_u64(vorrq_u64(a, b), vorrq_u64(c, d));
+    result = vgetq_lane_u64(a, 0) | vgetq_lane_u64(a, 1);
+    (void)result;
+}
+
+static void store_neon(void *memory, size_t size)
+{
+    uint64_t *p = (uint64_t *)memory;
+    uint64x2_t v = vdupq_n_u64(SIMD_PATTERN);
+
+    for (size_t i = 0; i < size / 64; i++, p += 8)
+    {
+        vst1q_u64(p, v);
+        vst1q_u64(p + 2, v);
+        vst1q_u64(p + 4, v);
+        vst1q_u64(p + 6, v);
+    }
+}
+
+// stnp hints that the stored lines will not be read again soon
+static void store_neon_nt(void *memory, size_t size)
+{
+    uint8_t *p = (uint8_t *)memory;
+    uint64x2_t v = vdupq_n_u64(SIMD_PATTERN);
+
+    for (size_t i = 0; i < size / 64; i++, p += 64)
+    {
+        __asm__ volatile("stnp %q1, %q1, [%0]\n\t"
+                         "stnp %q1, %q1, [%0, #32]"
+                         : : "r"(p), "w"(v) : "memory");
+    }
+}
+
+static void copy_neon(void *memory, size_t size)
+{
+    const uint64_t *src = (const uint64_t *)memory;
+    uint64_t *dst = (uint64_t *)memory + size / 2 / sizeof(uint64_t);
+
+    for (size_t i = 0; i < size / 2 / 64; i++, src += 8, dst += 8)
+    {
+        vst1q_u64(dst, vld1q_u64(src));
+        vst1q_u64(dst + 2, vld1q_u64(src + 2));
+        vst1q_u64(dst + 4, vld1q_u64(src + 4));
+        vst1q_u64(dst + 6, vld1q_u64(src + 6));
+    }
+}
+
+static void copy_neon_nt(void *memory, size_t size)
+{
+    const uint64_t *src = (const uint64_t *)memory;
+    uint8_t *dst = (uint8_t *)memory + size / 2;
+
+    for (size_t i = 0; i < size / 2 / 64; i++, src += 8, dst += 64)
+    {
+        uint64x2_t a = vld1q_u64(src), b = vld1q_u64(src + 2);
+        uint64x2_t c = vld1q_u64(src + 4), d = vld1q_u64(src + 6);
+        __asm__ volatile("stnp %q1, %q2, [%0]\n\t"
+                         "stnp %q3, %q4, [%0, #32]"
+                         : : "r"(dst), "w"(a), "w"(b), "w"(c), "w"(d) : "memory");
+    }
+}
+
+static const struct test_function neon_functions[] = {
+    {"LOAD-NEON", load_neon},
+    {"LOAD-NEON-PF", load_neon_pf},
+    {"STORE-NEON", store_neon},
+    {"STORE-NEON-NT", store_neon_nt},
+    {"COPY-NEON", copy_neon},
+    {"COPY-NEON-NT", copy_neon_nt},
+};
+
+#endif
+
+#define SIMD_MAX_FUNCTIONS 32
+
+static struct test_function simd_functions[SIMD_MAX_FUNCTIONS];
+static size_t simd_function_count;
+static int simd_detected;
+
+static void simd_append(const struct test_function *functions, size_t count)
+{
+    for (size_t i = 0; i < count && simd_function_count < SIMD_MAX_FUNCTIONS; i++)
+    {
+        simd_functions[simd_function_count++] = functions[i];
+    }
+}
+
+size_t simd_test_functions(const struct test_function **list)
+{
+    if (!simd_detected)
+    {
+        simd_detected = 1;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+        {
+            simd_append(sse2_functions, sizeof(sse2_functions) / sizeof(sse2_functions[0]));
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            simd_append(avx2_functions, sizeof(avx2_functions) / sizeof(avx2_functions[0]));
+        }
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            simd_append(avx512_functions, sizeof(avx512_functions) / sizeof(avx512_functions[0]));
+        }
+#elif defined(__aarch64__)
+        // advanced simd is part of the aarch64 baseline
+        simd_append(neon_functions, sizeof(neon_functions) / sizeof(neon_functions[0]));
+#endif
+    }
+    *list = simd_functions;
+    return simd_function_count;
+}
@@ -0,0 +1,17 @@
+#ifndef __memtest_simd_h__
+#define __memtest_simd_h__
+
+#include <stddef.h>
+
+struct test_function
+{
+    const char *name;
+    void (*func)(void *, size_t);
+};
+
+// explicit vector kernels the running cpu supports, named OPERATION-ISA[-NT|-PF]:
+// -NT uses non-temporal stores, -PF prefetches loads ahead in software
+// sizes passed to the kernels must be multiples of 512 bytes, COPY uses both halves
+size_t simd_test_functions(const struct test_function **list);
+
+#endif
@@ -0,0 +1,385 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "multitask.h"
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define PAGE_4K (4096ul)
+#define PAGE_2M (2ul * 1024 * 1024)
+#define PAGE_1G (1024ul * 1024 * 1024)
+
+static const char *mt_alloc_policy_names[MT_ALLOC_POLICY_COUNT] = {
+    [MT_ALLOC_DEFAULT] = "default",
+    [MT_ALLOC_4K] = "4k",
+    [MT_ALLOC_THP] = "thp",
+    [MT_ALLOC_2M] = "2m",
+    [MT_ALLOC_1G] = "1g",
+    [MT_ALLOC_INTERLEAVE] = "interleave",
+};
+
+static unsigned int mt_alloc_policy = MT_ALLOC_DEFAULT;
+static unsigned int mt_alloc_effective;     // bitmask of policies that took effect
+static int mt_thp_disabled = -1;            // -1: not checked yet
+
+// address range and bytes of the thp mappings since the last mt_alloc_take_effective,
+// MADV_HUGEPAGE is only a hint, smaps tells whether huge pages back the range
+static pthread_mutex_t mt_thp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uintptr_t mt_thp_start = UINTPTR_MAX;
+static uintptr_t mt_thp_end;
+static size_t mt_thp_bytes;
+
+int mt_alloc_set_policy(const char *name)
+{
+    for (unsigned int i = 0; i < MT_ALLOC_POLICY_COUNT; i++)
+    {
+        if (strcmp(name, mt_alloc_policy_names[i]) == 0)
+        {
+            mt_alloc_policy = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+unsigned int mt_alloc_get_policy(void)
+{
+    return mt_alloc_policy;
+}
+
+const char *mt_alloc_policy_name(unsigned int policy)
+{
+    return policy < MT_ALLOC_POLICY_COUNT ? mt_alloc_policy_names[policy] : "unknown";
+}
+
+// AnonHugePages of the mappings overlapping [start, end) in bytes, -1 if smaps cannot be read
+static long long thp_backed_bytes(uintptr_t start, uintptr_t end)
+{
+    FILE *f = fopen("/proc/self/smaps", "r");
+    char line[256];
+    unsigned long vma_start, vma_end, kb;
+    int overlap = 0;
+    long long bytes = 0;
+
+    if (!f)
+    {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "%lx-%lx ", &vma_start, &vma_end) == 2)
+        {
+            overlap = vma_start < end && vma_end > start;
+        }
+        else if (overlap && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+        {
+            bytes += kb * 1024ll;
+        }
+    }
+    fclose(f);
+    return bytes;
+}
+
+unsigned int mt_alloc_take_effective(void)
+{
+    unsigned int effective = __atomic_exchange_n(&mt_alloc_effective, 0, __ATOMIC_RELAXED);
+    uintptr_t start, end;
+    size_t bytes;
+    long long backed;
+
+    pthread_mutex_lock(&mt_thp_mutex);
+    start = mt_thp_start;
+    end = mt_thp_end;
+    bytes = mt_thp_bytes;
+    mt_thp_start = UINTPTR_MAX;
+    mt_thp_end = 0;
+    mt_thp_bytes = 0;
+    pthread_mutex_unlock(&mt_thp_mutex);
+
+    // the memory is touched by now, thp counts only for what huge pages back,
+    // both thp and 4k when they back part of it
+    if ((effective & (1u << MT_ALLOC_THP)) && bytes && (backed = thp_backed_bytes(start, end)) >= 0)
+    {
+        if ((size_t)backed < bytes)
+        {
+            effective |= 1u << MT_ALLOC_4K;
+        }
+        if (!backed)
+        {
+            effective &= ~(1u << MT_ALLOC_THP);
+        }
+    }
+    return effective;
+}
+
+static void mark_effective(unsigned int policy)
+{
+    __atomic_fetch_or(&mt_alloc_effective, 1u << policy, __ATOMIC_RELAXED);
+}
+
+static int thp_disabled(void)
+{
+    if (mt_thp_disabled < 0)
+    {
+        char buffer[128] = "";
+        FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (f)
+        {
+            if (!fgets(buffer, sizeof(buffer), f))
+            {
+                buffer[0] = 0;
+            }
+            fclose(f);
+        }
+        mt_thp_disabled = !f || strstr(buffer, "[never]") != NULL;
+    }
+    return mt_thp_disabled;
+}
+
+static size_t round_up(size_t size, size_t align)
+{
+    return (size + align - 1) & ~(align - 1);
+}
+
+static size_t huge_page_size(unsigned int policy)
+{
+    return policy == MT_ALLOC_1G ? PAGE_1G : PAGE_2M;
+}
+
+// allocations smaller than half a huge page are not worth a huge page, they take the thp path
+static unsigned int policy_for(size_t size)
+{
+    unsigned int policy = mt_alloc_policy;
+
+    if ((policy == MT_ALLOC_2M || policy == MT_ALLOC_1G) && size < huge_page_size(policy) / 2)
+    {
+        return MT_ALLOC_THP;
+    }
+#ifdef HAVE_NUMA
+    if (policy == MT_ALLOC_INTERLEAVE && numa_available() < 0)
+    {
+        return MT_ALLOC_DEFAULT;
+    }
+#else
+    if (policy == MT_ALLOC_INTERLEAVE)
+    {
+        return MT_ALLOC_DEFAULT;
+    }
+#endif
+    return policy;
+}
+
+// mapping length used by alloc and free, must depend on policy and size only
+static size_t mapping_size(unsigned int policy, size_t size)
+{
+    switch (policy)
+    {
+    case MT_ALLOC_2M:
+    case MT_ALLOC_1G:
+        return round_up(size, huge_page_size(policy));
+    case MT_ALLOC_THP:
+        return round_up(size, size >= PAGE_2M ? PAGE_2M : PAGE_4K);
+    default:
+        return round_up(size, PAGE_4K);
+    }
+}
+
+// anonymous mapping of size aligned to align, so that THP can back it from the first byte
+static void *map_aligned(size_t size, size_t align)
+{
+    size_t length = size + align - PAGE_4K;
+    uint8_t *p = (uint8_t *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uint8_t *aligned;
+
+    if (p == MAP_FAILED)
+    {
+        return NULL;
+    }
+    aligned = (uint8_t *)round_up((uintptr_t)p, align);
+    if (aligned > p)
+    {
+        munmap(p, aligned - p);
+    }
+    if (p + length > aligned + size)
+    {
+        munmap(aligned + size, p + length - (aligned + size));
+    }
+    return aligned;
+}
+
+static void *alloc_thp(size_t size)
+{
+    void *p = map_aligned(size, size >= PAGE_2M ? PAGE_2M : PAGE_4K);
+    if (p)
+    {
+        madvise(p, size, MADV_HUGEPAGE);
+        if (thp_disabled())
+        {
+            mark_effective(MT_ALLOC_4K);
+            return p;
+        }
+        pthread_mutex_lock(&mt_thp_mutex);
+        mt_thp_start = (uintptr_t)p < mt_thp_start ? (uintptr_t)p : mt_thp_start;
+        mt_thp_end = (uintptr_t)p + size > mt_thp_end ? (uintptr_t)p + size : mt_thp_end;
+        mt_thp_bytes += size;
+        pthread_mutex_unlock(&mt_thp_mutex);
+        mark_effective(MT_ALLOC_THP);
+    }
+    return p;
+}
+
+void *mt_alloc(size_t size)
+{
+    unsigned int policy = policy_for(size);
+    size_t length = mapping_size(policy, size);
+    void *p;
+
+    switch (policy)
+    {
+    case MT_ALLOC_4K:
+        p = map_aligned(length, PAGE_4K);
+        if (p)
+        {
+            madvise(p, length, MADV_NOHUGEPAGE);
+            mark_effective(MT_ALLOC_4K);
+        }
+        return p;
+    case MT_ALLOC_THP:
+        return alloc_thp(length);
+    case MT_ALLOC_2M:
+    case MT_ALLOC_1G:
+        p = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (policy == MT_ALLOC_1G ? MAP_HUGE_1GB : MAP_HUGE_2MB), -1, 0);
+        if (p != MAP_FAILED)
+        {
+            mark_effective(policy);
+            return p;
+        }
+        // no huge pages reserved, fall back to thp on the same length so that free stays symmetric
+        return alloc_thp(length);
+#ifdef HAVE_NUMA
+    case MT_ALLOC_INTERLEAVE:
+        mark_effective(MT_ALLOC_INTERLEAVE);
+        return numa_alloc_interleaved(size);
+#endif
+    default:
+        break;
+    }
+
+    mark_effective(MT_ALLOC_DEFAULT);
+#ifdef HAVE_NUMA
+    if (numa_available() >= 0)
+    {
+        return numa_alloc_local(size);
+    }
+#endif
+    return malloc(size);
+}
+
+void *mt_alloc_onnode(size_t size, int node)
+{
+#ifdef HAVE_NUMA
+    if (numa_available() >= 0)
+    {
+        return node < 0 ? numa_alloc_interleaved(size) : numa_alloc_onnode(size, node);
+    }
+#endif
+    (void)size;
+    (void)node;
+    return NULL;
+}
+
+void mt_free_onnode(void *ptr, size_t size)
+{
+#ifdef HAVE_NUMA
+    numa_free(ptr, size);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+unsigned int mt_numa_nodes(int *nodes, unsigned int max, int with_cpus)
+{
+    unsigned int count = 0;
+#ifdef HAVE_NUMA
+    struct bitmask *mask;
+
+    if (numa_available() < 0)
+    {
+        return 0;
+    }
+    mask = numa_allocate_cpumask();
+    for (int node = 0; node <= numa_max_node() && count < max; node++)
+    {
+        if (!numa_bitmask_isbitset(numa_all_nodes_ptr, node))
+        {
+            continue;
+        }
+        if (with_cpus)
+        {
+            if (numa_node_to_cpus(node, mask) != 0 || numa_bitmask_weight(mask) == 0)
+            {
+                continue;
+            }
+        }
+        else if (numa_node_size64(node, NULL) <= 0)
+        {
+            continue;
+        }
+        nodes[count++] = node;
+    }
+    numa_free_cpumask(mask);
+#else
+    (void)nodes;
+    (void)max;
+    (void)with_cpus;
+#endif
+    return count;
+}
+
+void mt_free(void *ptr, size_t size)
+{
+    unsigned int policy = policy_for(size);
+
+    switch (policy)
+    {
+    case MT_ALLOC_4K:
+    case MT_ALLOC_THP:
+    case MT_ALLOC_2M:
+    case MT_ALLOC_1G:
+        munmap(ptr, mapping_size(policy, size));
+        return;
+#ifdef HAVE_NUMA
+    case MT_ALLOC_INTERLEAVE:
+        numa_free(ptr, size);
+        return;
+#endif
+    default:
+        break;
+    }
+
+#ifdef HAVE_NUMA
+    if (numa_available() >= 0)
+    {
+        numa_free(ptr, size);
+        return;
+    }
+#endif
+    (void)size;
+    free(ptr);
+}
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <math.h>
+#include "multitask-latency.h"
+
+double mt_ticks_per_ns(void)
+{
+    static double ticks_per_ns;
+    struct timespec start, now;
+    uint64_t start_ticks, elapsed;
+
+    if (ticks_per_ns > 0)
+    {
+        return ticks_per_ns;
+    }
+
+    // spin for 20ms against the monotonic clock
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    start_ticks = mt_ticks();
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (now.tv_sec - start.tv_sec) * 1000000000ull + now.tv_nsec - start.tv_nsec;
+    } while (elapsed < 20000000);
+    ticks_per_ns = (double)(mt_ticks() - start_ticks) / elapsed;
+    return ticks_per_ns;
+}
+
+struct mt_histogram *mt_histogram_new(void)
+{
+    struct mt_histogram *hist = (struct mt_histogram *)calloc(1, sizeof(struct mt_histogram));
+    hist->min = UINT64_MAX;
+    return hist;
+}
+
+void mt_histogram_delete(struct mt_histogram *hist)
+{
+    free(hist);
+}
+
+void mt_histogram_merge(struct mt_histogram *dst, const struct mt_histogram *src)
+{
+    for (unsigned int i = 0; i < MT_HIST_BUCKETS; i++)
+    {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    if (src->min < dst->min)
+    {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max)
+    {
+        dst->max = src->max;
+    }
+}
+
+static uint64_t bucket_upper_bound(unsigned int index)
+{
+    unsigned int shift;
+    uint64_t sub;
+
+    if (index < MT_HIST_SUB_COUNT)
+    {
+        return index;
+    }
+    shift = (index >> MT_HIST_SUB_BITS) - 1;
+    sub = MT_HIST_SUB_COUNT + (index & (MT_HIST_SUB_COUNT - 1));
+    return ((sub + 1) << shift) - 1;
+}
+
+uint64_t mt_histogram_percentile(const struct mt_histogram *hist, double percentile)
+{
+    uint64_t target;
+    uint64_t seen = 0;
+
+    if (!hist->count)
+    {
+        return 0;
+    }
+    target = (uint64_t)ceil(hist->count * percentile / 100.0);
+    if (target < 1)
+    {
+        target = 1;
+    }
+    for (unsigned int i = 0; i < MT_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= target)
+        {
+            uint64_t value = bucket_upper_bound(i);
+            return value > hist->max ? hist->max : value;
+        }
+    }
+    return hist->max;
+}
@@ -0,0 +1,77 @@
+#ifndef __multitask_latency_h__
+#define __multitask_latency_h__
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// log-linear histogram: every power of two is split into MT_HIST_SUB_COUNT buckets,
+// so relative error is below 1/MT_HIST_SUB_COUNT at any magnitude
+#define MT_HIST_SUB_BITS 5
+#define MT_HIST_SUB_COUNT (1u << MT_HIST_SUB_BITS)
+#define MT_HIST_BUCKETS ((64 - MT_HIST_SUB_BITS + 1) * MT_HIST_SUB_COUNT)
+
+struct mt_histogram
+{
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[MT_HIST_BUCKETS];
+};
+
+// cheap timestamp, convert with mt_ticks_per_ns
+static inline uint64_t mt_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static inline unsigned int mt_histogram_index(uint64_t value)
+{
+    unsigned int msb = 63 - __builtin_clzll(value | 1);
+    unsigned int shift;
+
+    if (msb < MT_HIST_SUB_BITS)
+    {
+        return (unsigned int)value;
+    }
+    shift = msb - MT_HIST_SUB_BITS;
+    return ((shift + 1) << MT_HIST_SUB_BITS) + (unsigned int)(value >> shift) - MT_HIST_SUB_COUNT;
+}
+
+static inline void mt_histogram_record(struct mt_histogram *hist, uint64_t value)
+{
+    hist->buckets[mt_histogram_index(value)]++;
+    hist->count++;
+    if (value < hist->min)
+    {
+        hist->min = value;
+    }
+    if (value > hist->max)
+    {
+        hist->max = value;
+    }
+}
+
+// calibrated once on first call
+double mt_ticks_per_ns(void);
+
+struct mt_histogram *mt_histogram_new(void);
+void mt_histogram_delete(struct mt_histogram *hist);
+void mt_histogram_merge(struct mt_histogram *dst, const struct mt_histogram *src);
+// value at percentile (0-100), reported as the upper bound of its bucket
+uint64_t mt_histogram_percentile(const struct mt_histogram *hist, double percentile);
+
+#endif
@@ -0,0 +1,457 @@
+#include <stdio.h>
+#include "multitask-output.h"
+#include "multitask-latency.h"
+#include "multitask-perf.h"
+#include "multitask-telemetry.h"
+
+static const double latency_percentiles[] = { 50, 90, 99, 99.9 };
+static const char *latency_names[] = { "p50", "p90", "p99", "p999" };
+
+static void json_string(FILE *f, const char *str)
+{
+    fputc('"', f);
+    for (; *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            fputc('\\', f);
+        }
+        if ((unsigned char)*str < 0x20)
+        {
+            fprintf(f, "\\u%04x", *str);
+            continue;
+        }
+        fputc(*str, f);
+    }
+    fputc('"', f);
+}
+
+static void json_u64_array(FILE *f, const uint64_t *values, unsigned int count)
+{
+    fputc('[', f);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        fprintf(f, "%s%llu", i ? "," : "", (unsigned long long)values[i]);
+    }
+    fputc(']', f);
+}
+
+static void json_result(FILE *f, const struct mt_result *r, double rate, int outlier, double scale)
+{
+    fprintf(f, "{\"rate\":%.2f,\"outlier\":%s,\"threads\":%u,\"duration\":%u,\"counter\":%llu,\"elapsed_ns\":%llu,\"workers\":",
+            rate, outlier ? "true" : "false", r->workers, r->duration,
+            (unsigned long long)r->counter, (unsigned long long)r->elapsed_ns);
+    json_u64_array(f, r->worker_counter, r->workers);
+    fprintf(f, ",\"worker_active_ns\":");
+    json_u64_array(f, r->worker_active_ns, r->workers);
+    fprintf(f, ",\"start_skew_ns\":%llu,\"stop_skew_ns\":%llu,\"overlap_ns\":%llu", (unsigned long long)r->start_skew_ns,
+            (unsigned long long)r->stop_skew_ns, (unsigned long long)r->overlap_ns);
+
+    if (mt_alloc_get_policy() != MT_ALLOC_DEFAULT)
+    {
+        int first = 1;
+        fprintf(f, ",\"alloc\":{\"requested\":\"%s\",\"effective\":[", mt_alloc_policy_name(mt_alloc_get_policy()));
+        for (unsigned int i = 0; i < MT_ALLOC_POLICY_COUNT; i++)
+        {
+            if (r->alloc_effective & (1u << i))
+            {
+                fprintf(f, "%s\"%s\"", first ? "" : ",", mt_alloc_policy_name(i));
+                first = 0;
+            }
+        }
+        fprintf(f, "]}");
+    }
+    if (r->warmup_ns)
+    {
+        fprintf(f, ",\"warmup\":{\"ns\":%llu,\"steady\":%s,\"cv\":%.4f}",
+                (unsigned long long)r->warmup_ns, r->warmup_steady ? "true" : "false", r->warmup_cv);
+    }
+    if (r->fixed_items)
+    {
+        fprintf(f, ",\"fixed\":{\"items\":%llu,\"serial_ns\":%llu,\"worker_finish_ns\":",
+                (unsigned long long)r->fixed_items, (unsigned long long)r->serial_ns);
+        json_u64_array(f, r->worker_finish_ns, r->workers);
+        fputc('}', f);
+    }
+    if (r->intervals)
+    {
+        fprintf(f, ",\"intervals\":{\"ns\":");
+        json_u64_array(f, r->interval_ns, r->intervals);
+        fprintf(f, ",\"counter\":[");
+        for (unsigned int i = 0; i < r->intervals; i++)
+        {
+            fprintf(f, "%s", i ? "," : "");
+            json_u64_array(f, &r->interval_counter[i * r->workers], r->workers);
+        }
+        fprintf(f, "]}");
+    }
+    if (r->latency && r->latency->count)
+    {
+        double ns_per_tick = 1.0 / mt_ticks_per_ns();
+        fprintf(f, ",\"latency_ns\":{");
+        for (unsigned int i = 0; i < sizeof(latency_percentiles) / sizeof(latency_percentiles[0]); i++)
+        {
+            fprintf(f, "\"%s\":%.0f,", latency_names[i], mt_histogram_percentile(r->latency, latency_percentiles[i]) * ns_per_tick);
+        }
+        fprintf(f, "\"max\":%.0f,\"samples\":%llu}", r->latency->max * ns_per_tick, (unsigned long long)r->latency->count);
+    }
+    if (r->telemetry)
+    {
+        const struct mt_telemetry_result *t = r->telemetry;
+        fprintf(f, ",\"telemetry\":{\"cpus\":[");
+        for (unsigned int i = 0; i < t->cpus; i++)
+        {
+            fprintf(f, "%s{\"cpu\":%d,\"freq_avg_mhz\":%.0f,\"freq_min_mhz\":%.0f}", i ? "," : "",
+                    t->cpu[i], t->freq_avg_mhz[i], t->freq_min_mhz[i]);
+        }
+        fputc(']', f);
+        if (t->zones)
+        {
+            fprintf(f, ",\"temp_min_c\":%.1f,\"temp_max_c\":%.1f", t->temp_min_c, t->temp_max_c);
+        }
+        if (t->packages && t->energy_j > 0)
+        {
+            fprintf(f, ",\"energy_j\":%.3f,\"power_w\":%.3f,\"per_joule\":%.3f", t->energy_j,
+                    t->energy_j / t->seconds, r->counter * scale / t->energy_j);
+        }
+        fputc('}', f);
+    }
+    if (r->perf)
+    {
+        int first = 1;
+        fprintf(f, ",\"perf\":{");
+        for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+        {
+            if (r->perf->valid & (1u << i))
+            {
+                fprintf(f, "%s\"%s\":%llu", first ? "" : ",", mt_perf_event_name(i), (unsigned long long)r->perf->value[i]);
+                first = 0;
+            }
+        }
+        fputc('}', f);
+    }
+    fputc('}', f);
+}
+
+void mt_output_json(FILE *f, const char *name, const struct mt_result *results, const double *rates,
+                    const int *outlier, unsigned int runs, const struct mt_stats *stats, double scale)
+{
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"rate\":%.2f,\"scale\":%.9g,\"runs\":%u", runs > 1 ? stats->median : rates[0], scale, runs);
+    if (runs > 1)
+    {
+        fprintf(f, ",\"stats\":{\"median\":%.2f,\"mean\":%.2f,\"best\":%.2f,\"worst\":%.2f,\"stddev\":%.2f,\"ci95\":%.2f}",
+                stats->median, stats->mean, stats->max, stats->min, stats->stddev, stats->ci95);
+    }
+    fprintf(f, ",\"results\":[");
+    for (unsigned int i = 0; i < runs; i++)
+    {
+        fprintf(f, "%s", i ? "," : "");
+        json_result(f, &results[i], rates[i], outlier[i], scale);
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+}
+
+static void csv_header(FILE *f)
+{
+    static int header_printed;
+
+    if (header_printed)
+    {
+        return;
+    }
+    fprintf(f, "name,threads,duration,run,rate,outlier,scale,counter,elapsed_ns,worker_counters");
+    for (unsigned int i = 0; i < sizeof(latency_names) / sizeof(latency_names[0]); i++)
+    {
+        fprintf(f, ",latency_%s_ns", latency_names[i]);
+    }
+    fprintf(f, ",latency_max_ns");
+    for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+    {
+        fprintf(f, ",%s", mt_perf_event_name(i));
+    }
+    fprintf(f, ",freq_avg_mhz,freq_min_mhz,temp_max_c,energy_j,start_skew_ns,stop_skew_ns,overlap_ns\n");
+    header_printed = 1;
+}
+
+// frequency average and minimum over all worker cpus
+static void csv_telemetry(FILE *f, const struct mt_telemetry_result *t)
+{
+    double avg = 0, min = 0;
+
+    if (t && t->cpus)
+    {
+        for (unsigned int i = 0; i < t->cpus; i++)
+        {
+            avg += t->freq_avg_mhz[i] / t->cpus;
+            min = i == 0 || t->freq_min_mhz[i] < min ? t->freq_min_mhz[i] : min;
+        }
+        fprintf(f, ",%.0f,%.0f", avg, min);
+    }
+    else
+    {
+        fprintf(f, ",,");
+    }
+    if (t && t->zones)
+    {
+        fprintf(f, ",%.1f", t->temp_max_c);
+    }
+    else
+    {
+        fprintf(f, ",");
+    }
+    if (t && t->packages)
+    {
+        fprintf(f, ",%.3f", t->energy_j);
+    }
+    else
+    {
+        fprintf(f, ",");
+    }
+}
+
+void mt_output_csv(FILE *f, const char *name, const struct mt_result *results, const double *rates,
+                   const int *outlier, unsigned int runs, double scale)
+{
+    csv_header(f);
+    for (unsigned int run = 0; run < runs; run++)
+    {
+        const struct mt_result *r = &results[run];
+
+        fprintf(f, "%s,%u,%u,%u,%.2f,%d,%.9g,%llu,%llu,", name, r->workers, r->duration, run, rates[run], outlier[run],
+                scale, (unsigned long long)r->counter, (unsigned long long)r->elapsed_ns);
+        for (unsigned int w = 0; w < r->workers; w++)
+        {
+            fprintf(f, "%s%llu", w ? ";" : "", (unsigned long long)r->worker_counter[w]);
+        }
+        for (unsigned int i = 0; i < sizeof(latency_percentiles) / sizeof(latency_percentiles[0]); i++)
+        {
+            if (r->latency && r->latency->count)
+            {
+                fprintf(f, ",%.0f", mt_histogram_percentile(r->latency, latency_percentiles[i]) / mt_ticks_per_ns());
+            }
+            else
+            {
+                fprintf(f, ",");
+            }
+        }
+        if (r->latency && r->latency->count)
+        {
+            fprintf(f, ",%.0f", r->latency->max / mt_ticks_per_ns());
+        }
+        else
+        {
+            fprintf(f, ",");
+        }
+        for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+        {
+            if (r->perf && (r->perf->valid & (1u << i)))
+            {
+                fprintf(f, ",%llu", (unsigned long long)r->perf->value[i]);
+            }
+            else
+            {
+                fprintf(f, ",");
+            }
+        }
+        csv_telemetry(f, r->telemetry);
+        fprintf(f, ",%llu,%llu,%llu", (unsigned long long)r->start_skew_ns, (unsigned long long)r->stop_skew_ns,
+                (unsigned long long)r->overlap_ns);
+        fprintf(f, "\n");
+    }
+    fflush(f);
+}
+
+static double slowdown(double alone, double mixed)
+{
+    return mixed > 0 ? alone / mixed : 0;
+}
+
+void mt_output_mix_json(FILE *f, const char *name, const struct mt_group *groups, unsigned int count,
+                        const double *alone, const double *mixed, const double *pair)
+{
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"mix\":[");
+    for (unsigned int g = 0; g < count; g++)
+    {
+        fprintf(f, "%s{\"name\":", g ? "," : "");
+        json_string(f, groups[g].name);
+        fprintf(f, ",\"workers\":%u,\"scale\":%.9g,\"alone\":%.2f,\"mixed\":%.2f,\"slowdown\":%.4f",
+                groups[g].workers, groups[g].scale, alone[g], mixed[g], slowdown(alone[g], mixed[g]));
+        if (pair)
+        {
+            int first = 1;
+            fprintf(f, ",\"next_to\":{");
+            for (unsigned int a = 0; a < count; a++)
+            {
+                if (a == g)
+                {
+                    continue;
+                }
+                fprintf(f, "%s", first ? "" : ",");
+                json_string(f, groups[a].name);
+                fprintf(f, ":{\"rate\":%.2f,\"slowdown\":%.4f}", pair[g * count + a], slowdown(alone[g], pair[g * count + a]));
+                first = 0;
+            }
+            fputc('}', f);
+        }
+        fputc('}', f);
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+}
+
+// the columns after worker_counters of a row without records
+static void csv_empty_tail(FILE *f)
+{
+    for (unsigned int i = 0; i < sizeof(latency_names) / sizeof(latency_names[0]) + 1 + MT_PERF_EVENT_COUNT; i++)
+    {
+        fputc(',', f);
+    }
+    csv_telemetry(f, NULL);
+    fprintf(f, ",,,\n");
+}
+
+static void csv_mix_row(FILE *f, const struct mt_group *group, const char *with, unsigned int duration, double rate)
+{
+    fprintf(f, "%s@%s,%u,%u,0,%.2f,0,%.9g,,,", group->name, with, group->workers, duration, rate, group->scale);
+    csv_empty_tail(f);
+}
+
+void mt_output_mix_csv(FILE *f, const struct mt_group *groups, unsigned int count, unsigned int duration,
+                       const double *alone, const double *mixed, const double *pair)
+{
+    csv_header(f);
+    for (unsigned int g = 0; g < count; g++)
+    {
+        csv_mix_row(f, &groups[g], "alone", duration, alone[g]);
+        csv_mix_row(f, &groups[g], "mixed", duration, mixed[g]);
+        for (unsigned int a = 0; pair && a < count; a++)
+        {
+            if (a != g)
+            {
+                csv_mix_row(f, &groups[g], groups[a].name, duration, pair[g * count + a]);
+            }
+        }
+    }
+    fflush(f);
+}
+
+void mt_output_sweep_json(FILE *f, const char *name, const double *threads, const double *rates,
+                          const double *speedup, unsigned int count, const struct mt_scaling *scaling)
+{
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"sweep\":[");
+    for (unsigned int i = 0; i < count; i++)
+    {
+        fprintf(f, "%s{\"threads\":%.0f,\"rate\":%.2f,\"speedup\":%.4f,\"efficiency\":%.4f}",
+                i ? "," : "", threads[i], rates[i], speedup[i], speedup[i] / threads[i]);
+    }
+    fprintf(f, "],\"knee_threads\":%.0f,\"amdahl\":{\"serial\":%.6f},\"usl\":{\"sigma\":%.6f,\"kappa\":%.8f,\"peak_threads\":%.1f}}\n",
+            threads[scaling->knee], scaling->amdahl_serial, scaling->usl_sigma, scaling->usl_kappa, scaling->usl_peak);
+    fflush(f);
+}
+
+void mt_output_size_json(FILE *f, const char *name, const unsigned int *threads, unsigned int thread_count,
+                         const size_t *sizes, unsigned int size_count, const double *rates)
+{
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"threads\":[");
+    for (unsigned int i = 0; i < thread_count; i++)
+    {
+        fprintf(f, "%s%u", i ? "," : "", threads[i]);
+    }
+    fprintf(f, "],\"sizes\":[");
+    for (unsigned int i = 0; i < size_count; i++)
+    {
+        fprintf(f, "%s{\"bytes\":%zu,\"rates\":[", i ? "," : "", sizes[i]);
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            fprintf(f, "%s%.2f", t ? "," : "", rates[i * thread_count + t]);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+}
+
+void mt_output_matrix_json(FILE *f, const char *name, const char *title, const char *unit,
+                           const char *const *rows, unsigned int row_count,
+                           const char *const *cols, unsigned int col_count, const double *values)
+{
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"matrix\":");
+    json_string(f, title);
+    fprintf(f, ",\"unit\":");
+    json_string(f, unit);
+    fprintf(f, ",\"rows\":[");
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        fprintf(f, "%s", r ? "," : "");
+        json_string(f, rows[r]);
+    }
+    fprintf(f, "],\"cols\":[");
+    for (unsigned int c = 0; c < col_count; c++)
+    {
+        fprintf(f, "%s", c ? "," : "");
+        json_string(f, cols[c]);
+    }
+    fprintf(f, "],\"values\":[");
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        fprintf(f, "%s[", r ? "," : "");
+        for (unsigned int c = 0; c < col_count; c++)
+        {
+            fprintf(f, "%s%.2f", c ? "," : "", values[r * col_count + c]);
+        }
+        fprintf(f, "]");
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+}
+
+void mt_output_matrix_csv(FILE *f, const char *name, const char *const *rows, unsigned int row_count,
+                          const char *const *cols, unsigned int col_count, const double *values)
+{
+    csv_header(f);
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        for (unsigned int c = 0; c < col_count; c++)
+        {
+            fprintf(f, "%s@%s@%s,,,0,%.2f,0,1,,,", name, rows[r], cols[c], values[r * col_count + c]);
+            csv_empty_tail(f);
+        }
+    }
+    fflush(f);
+}
+
+void mt_output_load_json(FILE *f, const char *name, unsigned int tasks, const char *arrival,
+                         const struct mt_load_point *points, unsigned int count)
+{
+    double ns_per_tick = 1.0 / mt_ticks_per_ns();
+
+    fprintf(f, "{\"name\":");
+    json_string(f, name);
+    fprintf(f, ",\"threads\":%u,\"arrival\":\"%s\",\"load\":[", tasks, arrival);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const struct mt_histogram *hist = points[i].latency;
+        double achieved = points[i].elapsed_ns ? points[i].calls / (points[i].elapsed_ns / 1000000000.0) : 0;
+
+        fprintf(f, "%s{\"target\":%.2f,\"achieved\":%.2f,\"latency_ns\":{", i ? "," : "", points[i].target, achieved);
+        for (unsigned int p = 0; p < sizeof(latency_percentiles) / sizeof(latency_percentiles[0]); p++)
+        {
+            fprintf(f, "\"%s\":%.0f,", latency_names[p], mt_histogram_percentile(hist, latency_percentiles[p]) * ns_per_tick);
+        }
+        fprintf(f, "\"max\":%.0f,\"samples\":%llu}}", hist->count ? hist->max * ns_per_tick : 0,
+                (unsigned long long)hist->count);
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+}
@@ -0,0 +1,58 @@
+#ifndef __multitask_output_h__
+#define __multitask_output_h__
+
+#include <stdio.h>
+#include "multitask.h"
+#include "multitask-stats.h"
+
+// structured output of one case, results/rates/outlier hold every run,
+// rates are in the printed unit and scale converts counter rates to it
+
+// open-loop load point, latency of every call of all runs at one target rate
+struct mt_load_point
+{
+    double target;                          // test calls per second of all workers
+    uint64_t calls;
+    uint64_t elapsed_ns;                    // sum of all runs
+    struct mt_histogram *latency;           // ticks from the scheduled start of every call
+};
+
+// one JSON object per line
+void mt_output_json(FILE *f, const char *name, const struct mt_result *results, const double *rates,
+                    const int *outlier, unsigned int runs, const struct mt_stats *stats, double scale);
+// one row per run, the header is printed before the first row
+void mt_output_csv(FILE *f, const char *name, const struct mt_result *results, const double *rates,
+                   const int *outlier, unsigned int runs, double scale);
+
+// mixed mode, alone and mixed hold the rate of every group, pair[victim * count + aggressor]
+// the rate of victim next to aggressor only, NULL if pairs were not run
+void mt_output_mix_json(FILE *f, const char *name, const struct mt_group *groups, unsigned int count,
+                        const double *alone, const double *mixed, const double *pair);
+// one row per group and run, named group@alone, group@mixed and group@aggressor,
+// with the same header as mt_output_csv
+void mt_output_mix_csv(FILE *f, const struct mt_group *groups, unsigned int count, unsigned int duration,
+                       const double *alone, const double *mixed, const double *pair);
+
+// thread count sweep summary of one case, one JSON line after the records of every thread count
+void mt_output_sweep_json(FILE *f, const char *name, const double *threads, const double *rates,
+                          const double *speedup, unsigned int count, const struct mt_scaling *scaling);
+
+// working set sweep of one case, rates[size * thread_count + thread] in the printed unit,
+// one JSON line after the records of every size
+void mt_output_size_json(FILE *f, const char *name, const unsigned int *threads, unsigned int thread_count,
+                         const size_t *sizes, unsigned int size_count, const double *rates);
+
+// matrix of one case named by title, values[row * col_count + col] in unit, one JSON line
+void mt_output_matrix_json(FILE *f, const char *name, const char *title, const char *unit,
+                           const char *const *rows, unsigned int row_count,
+                           const char *const *cols, unsigned int col_count, const double *values);
+// one row per cell named name@row@col with the value as rate, for matrices without
+// records of their own, with the same header as mt_output_csv
+void mt_output_matrix_csv(FILE *f, const char *name, const char *const *rows, unsigned int row_count,
+                          const char *const *cols, unsigned int col_count, const double *values);
+
+// open-loop latency against load of one case, one JSON line after the records of every target
+void mt_output_load_json(FILE *f, const char *name, unsigned int tasks, const char *arrival,
+                         const struct mt_load_point *points, unsigned int count);
+
+#endif
@@ -0,0 +1,212 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "multitask-perf.h"
+
+struct perf_event_desc
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+static const struct perf_event_desc perf_events[MT_PERF_EVENT_COUNT] = {
+    [MT_PERF_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [MT_PERF_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [MT_PERF_LLC_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [MT_PERF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [MT_PERF_DTLB_MISSES] = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    [MT_PERF_TASK_CLOCK] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    [MT_PERF_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    [MT_PERF_CPU_MIGRATIONS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+    [MT_PERF_PAGE_FAULTS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+static const char *perf_event_names[MT_PERF_EVENT_COUNT] = {
+    [MT_PERF_CYCLES] = "cycles",
+    [MT_PERF_INSTRUCTIONS] = "instructions",
+    [MT_PERF_LLC_MISSES] = "llc_misses",
+    [MT_PERF_BRANCH_MISSES] = "branch_misses",
+    [MT_PERF_DTLB_MISSES] = "dtlb_misses",
+    [MT_PERF_TASK_CLOCK] = "task_clock_ns",
+    [MT_PERF_CONTEXT_SWITCHES] = "context_switches",
+    [MT_PERF_CPU_MIGRATIONS] = "cpu_migrations",
+    [MT_PERF_PAGE_FAULTS] = "page_faults",
+};
+
+const char *mt_perf_event_name(unsigned int event)
+{
+    return event < MT_PERF_EVENT_COUNT ? perf_event_names[event] : "unknown";
+}
+
+static int perf_event_open(const struct perf_event_desc *desc, int group_fd)
+{
+    struct perf_event_attr attr;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = desc->type;
+    attr.config = desc->config;
+    attr.disabled = group_fd < 0;
+    // the kernel counts context switches and migrations in kernel mode, excluding it would
+    // leave them at 0, hardware events stay on the user code of the test
+    attr.exclude_kernel = desc->type != PERF_TYPE_SOFTWARE;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    if (fd < 0 && !attr.exclude_kernel)
+    {
+        // perf_event_paranoid may forbid kernel counting for unprivileged users
+        attr.exclude_kernel = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    }
+    return fd;
+}
+
+static void perf_open_group(struct mt_perf *perf, unsigned int leader, unsigned int first, unsigned int last)
+{
+    perf->fd[leader] = perf_event_open(&perf_events[leader], -1);
+    if (perf->fd[leader] < 0)
+    {
+        return;
+    }
+    perf->leader = perf->fd[leader];
+    for (unsigned int i = first; i <= last; i++)
+    {
+        if (i != leader)
+        {
+            // a member the cpu does not support is left out of the group
+            perf->fd[i] = perf_event_open(&perf_events[i], perf->leader);
+        }
+    }
+}
+
+struct mt_perf *mt_perf_open(void)
+{
+    struct mt_perf *perf = (struct mt_perf *)calloc(1, sizeof(struct mt_perf));
+
+    for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+    {
+        perf->fd[i] = -1;
+    }
+    perf->leader = -1;
+
+    perf_open_group(perf, MT_PERF_CYCLES, MT_PERF_CYCLES, MT_PERF_PAGE_FAULTS);
+    if (perf->leader < 0)
+    {
+        perf_open_group(perf, MT_PERF_TASK_CLOCK, MT_PERF_TASK_CLOCK, MT_PERF_PAGE_FAULTS);
+    }
+    if (perf->leader < 0)
+    {
+        free(perf);
+        return NULL;
+    }
+    return perf;
+}
+
+void mt_perf_close(struct mt_perf *perf)
+{
+    if (!perf)
+    {
+        return;
+    }
+    for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+    {
+        if (perf->fd[i] >= 0)
+        {
+            close(perf->fd[i]);
+        }
+    }
+    free(perf);
+}
+
+void mt_perf_start(struct mt_perf *perf)
+{
+    ioctl(perf->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void mt_perf_stop(struct mt_perf *perf)
+{
+    ioctl(perf->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+    {
+        uint64_t buffer[3];                 // value, time enabled, time running
+
+        if (perf->fd[i] < 0 || read(perf->fd[i], buffer, sizeof(buffer)) != sizeof(buffer) || !buffer[2])
+        {
+            continue;
+        }
+        perf->counts.valid |= 1u << i;
+        perf->counts.value[i] += (uint64_t)((double)buffer[0] * buffer[1] / buffer[2]);
+    }
+}
+
+void mt_perf_merge(struct mt_perf_counts *dst, const struct mt_perf_counts *src)
+{
+    dst->valid |= src->valid;
+    for (unsigned int i = 0; i < MT_PERF_EVENT_COUNT; i++)
+    {
+        dst->value[i] += src->value[i];
+    }
+}
+
+void mt_perf_print(FILE *f, const struct mt_perf_counts *counts, uint64_t counter, const char *unit)
+{
+    const uint64_t *v = counts->value;
+    double per_step = counter ? 1.0 / counter : 0;
+
+#define PERF_VALID(event) (counts->valid & (1u << (event)))
+    fprintf(f, "  perf");
+    if (PERF_VALID(MT_PERF_CYCLES) && PERF_VALID(MT_PERF_INSTRUCTIONS) && v[MT_PERF_CYCLES])
+    {
+        fprintf(f, " ipc %.2f", (double)v[MT_PERF_INSTRUCTIONS] / v[MT_PERF_CYCLES]);
+    }
+    if (PERF_VALID(MT_PERF_CYCLES) && PERF_VALID(MT_PERF_TASK_CLOCK) && v[MT_PERF_TASK_CLOCK])
+    {
+        fprintf(f, " ghz %.2f", (double)v[MT_PERF_CYCLES] / v[MT_PERF_TASK_CLOCK]);
+    }
+    if (PERF_VALID(MT_PERF_INSTRUCTIONS))
+    {
+        fprintf(f, " insn/%s %.4g", unit, v[MT_PERF_INSTRUCTIONS] * per_step);
+    }
+    if (PERF_VALID(MT_PERF_LLC_MISSES))
+    {
+        fprintf(f, " llc-miss/%s %.4g", unit, v[MT_PERF_LLC_MISSES] * per_step);
+    }
+    if (PERF_VALID(MT_PERF_BRANCH_MISSES))
+    {
+        fprintf(f, " br-miss/%s %.4g", unit, v[MT_PERF_BRANCH_MISSES] * per_step);
+    }
+    if (PERF_VALID(MT_PERF_DTLB_MISSES))
+    {
+        fprintf(f, " dtlb-miss/%s %.4g", unit, v[MT_PERF_DTLB_MISSES] * per_step);
+    }
+    if (PERF_VALID(MT_PERF_TASK_CLOCK))
+    {
+        fprintf(f, " task-clock %.3fs", v[MT_PERF_TASK_CLOCK] / 1000000000.0);
+    }
+    if (PERF_VALID(MT_PERF_CONTEXT_SWITCHES))
+    {
+        fprintf(f, " cs %llu", (unsigned long long)v[MT_PERF_CONTEXT_SWITCHES]);
+    }
+    if (PERF_VALID(MT_PERF_CPU_MIGRATIONS))
+    {
+        fprintf(f, " migrations %llu", (unsigned long long)v[MT_PERF_CPU_MIGRATIONS]);
+    }
+    if (PERF_VALID(MT_PERF_PAGE_FAULTS))
+    {
+        fprintf(f, " faults %llu", (unsigned long long)v[MT_PERF_PAGE_FAULTS]);
+    }
+    if (!PERF_VALID(MT_PERF_CYCLES))
+    {
+        fprintf(f, " (software events only)");
+    }
+    fprintf(f, "\n");
+#undef PERF_VALID
+}
@@ -0,0 +1,51 @@
+#ifndef __multitask_perf_h__
+#define __multitask_perf_h__
+
+#include <stdio.h>
+#include <stdint.h>
+
+enum
+{
+    MT_PERF_CYCLES,
+    MT_PERF_INSTRUCTIONS,
+    MT_PERF_LLC_MISSES,
+    MT_PERF_BRANCH_MISSES,
+    MT_PERF_DTLB_MISSES,
+    MT_PERF_TASK_CLOCK,                     // ns the thread was on a cpu
+    MT_PERF_CONTEXT_SWITCHES,
+    MT_PERF_CPU_MIGRATIONS,
+    MT_PERF_PAGE_FAULTS,
+    MT_PERF_EVENT_COUNT,
+};
+
+struct mt_perf_counts
+{
+    unsigned int valid;                     // bitmask of events that could be counted
+    uint64_t value[MT_PERF_EVENT_COUNT];    // scaled when the group was multiplexed
+};
+
+// counters of one thread, opened as one group so all events cover the same window
+struct mt_perf
+{
+    int fd[MT_PERF_EVENT_COUNT];
+    int leader;
+    struct mt_perf_counts counts;
+};
+
+// open the counters of the calling thread, hardware events first, software events when
+// hardware events are not available (containers, VMs), return NULL when nothing can be opened
+struct mt_perf *mt_perf_open(void);
+void mt_perf_close(struct mt_perf *perf);
+void mt_perf_start(struct mt_perf *perf);
+// stop counting and add the window to perf->counts
+void mt_perf_stop(struct mt_perf *perf);
+
+// snake case name of event, used by structured output
+const char *mt_perf_event_name(unsigned int event);
+
+void mt_perf_merge(struct mt_perf_counts *dst, const struct mt_perf_counts *src);
+// print derived metrics, counter is the counter of the measured window and unit what one
+// counter step counts, the per step metrics are labelled like insn/byte
+void mt_perf_print(FILE *f, const struct mt_perf_counts *counts, uint64_t counter, const char *unit);
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "multitask-stats.h"
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median_of(const double *values, size_t count)
+{
+    double *sorted = (double *)malloc(sizeof(double) * count);
+    double median;
+
+    memcpy(sorted, values, sizeof(double) * count);
+    qsort(sorted, count, sizeof(double), compare_double);
+    if (count % 2)
+    {
+        median = sorted[count / 2];
+    }
+    else
+    {
+        median = (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    }
+    free(sorted);
+    return median;
+}
+
+// two sided 95% critical value of student's t distribution
+static double t_critical_95(size_t df)
+{
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+
+    if (df == 0)
+    {
+        return 0;
+    }
+    if (df <= sizeof(table) / sizeof(table[0]))
+    {
+        return table[df - 1];
+    }
+    return 1.960;
+}
+
+void mt_stats_compute(const double *values, size_t count, struct mt_stats *stats)
+{
+    double sum = 0;
+    double square_sum = 0;
+
+    stats->count = count;
+    stats->min = 0;
+    stats->max = 0;
+    stats->mean = 0;
+    stats->stddev = 0;
+    stats->median = 0;
+    stats->ci95 = 0;
+    if (!count)
+    {
+        return;
+    }
+
+    stats->min = values[0];
+    stats->max = values[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        if (values[i] < stats->min)
+        {
+            stats->min = values[i];
+        }
+        if (values[i] > stats->max)
+        {
+            stats->max = values[i];
+        }
+        sum += values[i];
+    }
+    stats->mean = sum / count;
+    stats->median = median_of(values, count);
+
+    if (count < 2)
+    {
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        double d = values[i] - stats->mean;
+        square_sum += d * d;
+    }
+    stats->stddev = sqrt(square_sum / (count - 1));
+    stats->ci95 = t_critical_95(count - 1) * stats->stddev / sqrt(count);
+}
+
+size_t mt_stats_outliers(const double *values, size_t count, int *outlier)
+{
+    double *deviation;
+    double median, mad;
+    size_t outliers = 0;
+
+    memset(outlier, 0, sizeof(int) * count);
+    if (count < 3)
+    {
+        return 0;
+    }
+
+    deviation = (double *)malloc(sizeof(double) * count);
+    median = median_of(values, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        deviation[i] = fabs(values[i] - median);
+    }
+    mad = median_of(deviation, count);
+    if (mad > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (0.6745 * deviation[i] / mad > 3.5)
+            {
+                outlier[i] = 1;
+                outliers++;
+            }
+        }
+    }
+    free(deviation);
+    return outliers;
+}
+
+double mt_stats_fairness(const double *values, size_t count)
+{
+    double sum = 0;
+    double square_sum = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += values[i];
+        square_sum += values[i] * values[i];
+    }
+    if (square_sum == 0)
+    {
+        return 1.0;
+    }
+    return sum * sum / (count * square_sum);
+}
+
+// added threads must gain at least this fraction of one thread
+#define MT_KNEE_MARGINAL 0.5
+
+void mt_stats_scaling(const double *threads, const double *speedup, size_t count, struct mt_scaling *scaling)
+{
+    double xx = 0, xy = 0;
+    double a = 0, b = 0, d = 0, y1 = 0, y2 = 0, det;
+
+    memset(scaling, 0, sizeof(struct mt_scaling));
+    for (size_t i = 1; i < count; i++)
+    {
+        if ((speedup[i] - speedup[i - 1]) / (threads[i] - threads[i - 1]) < MT_KNEE_MARGINAL)
+        {
+            break;
+        }
+        scaling->knee = i;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        double n = threads[i];
+        double x, y, x1, x2;
+
+        if (n <= 1 || speedup[i] <= 0)
+        {
+            continue;
+        }
+        // amdahl: 1/S - 1/n = s * (1 - 1/n)
+        x = 1 - 1 / n;
+        y = 1 / speedup[i] - 1 / n;
+        xx += x * x;
+        xy += x * y;
+
+        // usl: n/S - 1 = sigma * (n - 1) + kappa * n * (n - 1)
+        x1 = n - 1;
+        x2 = n * (n - 1);
+        y = n / speedup[i] - 1;
+        a += x1 * x1;
+        b += x1 * x2;
+        d += x2 * x2;
+        y1 += x1 * y;
+        y2 += x2 * y;
+    }
+    if (xx > 0)
+    {
+        scaling->amdahl_serial = fmin(fmax(xy / xx, 0), 1);
+    }
+
+    det = a * d - b * b;
+    if (det > 1e-9 * a * d)
+    {
+        scaling->usl_sigma = (y1 * d - y2 * b) / det;
+        scaling->usl_kappa = (y2 * a - y1 * b) / det;
+    }
+    else if (a > 0)
+    {
+        scaling->usl_sigma = y1 / a;
+    }
+    // refit with the negative coefficient fixed at 0
+    if (scaling->usl_kappa < 0)
+    {
+        scaling->usl_kappa = 0;
+        scaling->usl_sigma = a > 0 ? y1 / a : 0;
+    }
+    if (scaling->usl_sigma < 0)
+    {
+        scaling->usl_sigma = 0;
+        scaling->usl_kappa = d > 0 ? fmax(y2 / d, 0) : 0;
+    }
+    if (scaling->usl_kappa > 0 && scaling->usl_sigma < 1)
+    {
+        scaling->usl_peak = sqrt((1 - scaling->usl_sigma) / scaling->usl_kappa);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef __multitask_stats_h__
+#define __multitask_stats_h__
+
+#include <stddef.h>
+
+struct mt_stats
+{
+    size_t count;
+    double min;
+    double max;
+    double mean;
+    double stddev;                          // sample standard deviation
+    double median;
+    double ci95;                            // half width of the 95% confidence interval of mean
+};
+
+void mt_stats_compute(const double *values, size_t count, struct mt_stats *stats);
+
+// flag values whose modified z-score (median absolute deviation based) exceeds 3.5,
+// return the number of outliers
+size_t mt_stats_outliers(const double *values, size_t count, int *outlier);
+
+// Jain's fairness index, 1.0 when all values are equal, 1/count when one value takes all
+double mt_stats_fairness(const double *values, size_t count);
+
+// thread count sweep, speedup of point i is measured against the rate of one thread
+struct mt_scaling
+{
+    size_t knee;                            // index of the last point before adding threads stops paying off
+    double amdahl_serial;                   // serial fraction of Amdahl's law
+    double usl_sigma;                       // contention of the universal scalability law
+    double usl_kappa;                       // coherency delay of the universal scalability law
+    double usl_peak;                        // thread count of the highest modelled throughput, 0 if unbounded
+};
+
+// threads must be increasing, the knee is the last point before the speedup gained per added thread
+// drops below half of one thread, both models are least squares fits of their linearized form
+void mt_stats_scaling(const double *threads, const double *speedup, size_t count, struct mt_scaling *scaling);
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "multitask-steal.h"
+
+#define RANGE_PACK(next, end) (((uint64_t)(next) << 32) | (end))
+#define RANGE_NEXT(packed) ((uint32_t)((packed) >> 32))
+#define RANGE_END(packed) ((uint32_t)(packed))
+
+void mt_steal_init(struct mt_steal *steal, uint32_t items, unsigned int workers, uint32_t chunk)
+{
+    size_t size = sizeof(struct mt_steal_range) * workers;
+
+    steal->workers = workers;
+    steal->chunk = chunk;
+    if (!steal->chunk)
+    {
+        // small enough to balance the tail, large enough to keep the CAS off the hot path
+        steal->chunk = items / (workers * 64);
+        if (!steal->chunk)
+        {
+            steal->chunk = 1;
+        }
+    }
+    steal->ranges = (struct mt_steal_range *)aligned_alloc(sizeof(struct mt_steal_range), size);
+    if (!steal->ranges)
+    {
+        fprintf(stderr, "aligned_alloc(%zu) failed\n", size);
+        abort();
+    }
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        uint32_t begin = (uint64_t)items * i / workers;
+        uint32_t end = (uint64_t)items * (i + 1) / workers;
+        steal->ranges[i].packed = RANGE_PACK(begin, end);
+    }
+}
+
+void mt_steal_destroy(struct mt_steal *steal)
+{
+    free(steal->ranges);
+    memset(steal, 0, sizeof(struct mt_steal));
+}
+
+int mt_steal_next(struct mt_steal *steal, unsigned int self, uint32_t *begin, uint32_t *end)
+{
+    struct mt_steal_range *own = &steal->ranges[self];
+    uint64_t old = __atomic_load_n(&own->packed, __ATOMIC_ACQUIRE);
+
+    while (RANGE_NEXT(old) < RANGE_END(old))
+    {
+        uint32_t next = RANGE_NEXT(old);
+        uint32_t take = RANGE_END(old) - next < steal->chunk ? RANGE_END(old) - next : steal->chunk;
+
+        if (__atomic_compare_exchange_n(&own->packed, &old, RANGE_PACK(next + take, RANGE_END(old)),
+                                        0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            *begin = next;
+            *end = next + take;
+            return 1;
+        }
+    }
+
+    for (unsigned int i = 1; i < steal->workers; i++)
+    {
+        struct mt_steal_range *victim = &steal->ranges[(self + i) % steal->workers];
+
+        old = __atomic_load_n(&victim->packed, __ATOMIC_ACQUIRE);
+        while (RANGE_NEXT(old) < RANGE_END(old))
+        {
+            uint32_t remaining = RANGE_END(old) - RANGE_NEXT(old);
+            uint32_t split = RANGE_END(old) - (remaining + 1) / 2;
+
+            if (__atomic_compare_exchange_n(&victim->packed, &old, RANGE_PACK(RANGE_NEXT(old), split),
+                                            0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                // run the first chunk of the stolen half now, publish the rest so it can be stolen again
+                uint32_t take = RANGE_END(old) - split < steal->chunk ? RANGE_END(old) - split : steal->chunk;
+                __atomic_store_n(&own->packed, RANGE_PACK(split + take, RANGE_END(old)), __ATOMIC_RELEASE);
+                *begin = split;
+                *end = split + take;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef __multitask_steal_h__
+#define __multitask_steal_h__
+
+#include <stdint.h>
+#include "multitask.h"
+
+// work item ranges of fixed-work mode, every worker owns one range [next, end)
+// packed in one 64 bit word, so owner and thieves update it with a single CAS
+struct mt_steal_range
+{
+    uint64_t packed;
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
+
+struct mt_steal
+{
+    unsigned int workers;
+    uint32_t chunk;                         // items the owner takes from its range at once
+    struct mt_steal_range *ranges;
+};
+
+// split items evenly over workers, chunk 0 picks a chunk size from items and workers
+void mt_steal_init(struct mt_steal *steal, uint32_t items, unsigned int workers, uint32_t chunk);
+void mt_steal_destroy(struct mt_steal *steal);
+
+// take the next chunk of worker self, steal half of another worker's range when its own is empty,
+// return 0 when no work is left
+int mt_steal_next(struct mt_steal *steal, unsigned int self, uint32_t *begin, uint32_t *end);
+
+#endif
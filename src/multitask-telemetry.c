@@ -0,0 +1,354 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "multitask-telemetry.h"
+
+#define MT_TELEMETRY_INTERVAL_MS 200
+
+struct mt_telemetry_rapl
+{
+    char path[256];
+    uint64_t max_range_uj;                  // energy_uj wraps around at this value
+    uint64_t last_uj;
+    uint64_t total_uj;
+};
+
+struct mt_telemetry
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned int stop_flag;
+    struct timespec start_time;
+
+    unsigned int cpus;
+    int *cpu;
+    double *freq_sum_khz;
+    double *freq_min_khz;
+    unsigned int freq_samples;
+
+    unsigned int zones;
+    char (*zone_path)[64];
+    double temp_min_c;
+    double temp_max_c;
+    unsigned int temp_samples;
+
+    unsigned int packages;
+    struct mt_telemetry_rapl *rapl;
+};
+
+static int read_u64(const char *path, uint64_t *value)
+{
+    FILE *f = fopen(path, "r");
+    unsigned long long v;
+    int ok;
+
+    if (!f)
+    {
+        return -1;
+    }
+    ok = fscanf(f, "%llu", &v) == 1;
+    fclose(f);
+    if (!ok)
+    {
+        return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+static int read_i64(const char *path, int64_t *value)
+{
+    FILE *f = fopen(path, "r");
+    long long v;
+    int ok;
+
+    if (!f)
+    {
+        return -1;
+    }
+    ok = fscanf(f, "%lld", &v) == 1;
+    fclose(f);
+    if (!ok)
+    {
+        return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+static int read_cpu_khz(int cpu, uint64_t *khz)
+{
+    char path[128];
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+    if (read_u64(path, khz) == 0)
+    {
+        return 0;
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_cur_freq", cpu);
+    return read_u64(path, khz);
+}
+
+static void find_cpus(struct mt_telemetry *t, const cpu_set_t *cpus)
+{
+    t->cpu = (int *)malloc(sizeof(int) * CPU_COUNT(cpus));
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        uint64_t khz;
+        if (CPU_ISSET(cpu, cpus) && read_cpu_khz(cpu, &khz) == 0)
+        {
+            t->cpu[t->cpus++] = cpu;
+        }
+    }
+    t->freq_sum_khz = (double *)calloc(t->cpus ? t->cpus : 1, sizeof(double));
+    t->freq_min_khz = (double *)calloc(t->cpus ? t->cpus : 1, sizeof(double));
+}
+
+static void find_zones(struct mt_telemetry *t)
+{
+    DIR *dir = opendir("/sys/class/thermal");
+    struct dirent *entry;
+
+    if (!dir)
+    {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        char path[64];
+        int64_t temp;
+
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0 || strlen(entry->d_name) > 32)
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/class/thermal/%s/temp", entry->d_name);
+        if (read_i64(path, &temp) != 0)
+        {
+            continue;
+        }
+        t->zone_path = realloc(t->zone_path, sizeof(t->zone_path[0]) * (t->zones + 1));
+        memcpy(t->zone_path[t->zones++], path, sizeof(path));
+    }
+    closedir(dir);
+}
+
+// top level rapl zones like intel-rapl:0 are packages, intel-rapl:0:0 are their subdomains
+static void find_rapl(struct mt_telemetry *t)
+{
+    DIR *dir = opendir("/sys/class/powercap");
+    struct dirent *entry;
+
+    if (!dir)
+    {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        struct mt_telemetry_rapl rapl;
+        char path[256];
+        const char *colon = strchr(entry->d_name, ':');
+
+        if (!colon || strchr(colon + 1, ':') || strlen(entry->d_name) > 64)
+        {
+            continue;
+        }
+        memset(&rapl, 0, sizeof(rapl));
+        snprintf(rapl.path, sizeof(rapl.path), "/sys/class/powercap/%s/energy_uj", entry->d_name);
+        snprintf(path, sizeof(path), "/sys/class/powercap/%s/max_energy_range_uj", entry->d_name);
+        // energy_uj is often readable by root only
+        if (read_u64(rapl.path, &rapl.last_uj) != 0 || read_u64(path, &rapl.max_range_uj) != 0)
+        {
+            continue;
+        }
+        t->rapl = realloc(t->rapl, sizeof(struct mt_telemetry_rapl) * (t->packages + 1));
+        t->rapl[t->packages++] = rapl;
+    }
+    closedir(dir);
+}
+
+static void sample(struct mt_telemetry *t)
+{
+    for (unsigned int i = 0; i < t->cpus; i++)
+    {
+        uint64_t khz;
+        if (read_cpu_khz(t->cpu[i], &khz) != 0)
+        {
+            khz = 0;
+        }
+        t->freq_sum_khz[i] += khz;
+        if (t->freq_samples == 0 || khz < t->freq_min_khz[i])
+        {
+            t->freq_min_khz[i] = khz;
+        }
+    }
+    t->freq_samples++;
+
+    for (unsigned int i = 0; i < t->zones; i++)
+    {
+        int64_t temp;
+        double c;
+        if (read_i64(t->zone_path[i], &temp) != 0)
+        {
+            continue;
+        }
+        c = temp / 1000.0;
+        if (t->temp_samples == 0 || c < t->temp_min_c)
+        {
+            t->temp_min_c = c;
+        }
+        if (t->temp_samples == 0 || c > t->temp_max_c)
+        {
+            t->temp_max_c = c;
+        }
+        t->temp_samples++;
+    }
+
+    for (unsigned int i = 0; i < t->packages; i++)
+    {
+        struct mt_telemetry_rapl *rapl = &t->rapl[i];
+        uint64_t uj;
+        if (read_u64(rapl->path, &uj) != 0)
+        {
+            continue;
+        }
+        rapl->total_uj += uj >= rapl->last_uj ? uj - rapl->last_uj : rapl->max_range_uj - rapl->last_uj + uj;
+        rapl->last_uj = uj;
+    }
+}
+
+static void *telemetry_entry(void *arg)
+{
+    struct mt_telemetry *t = (struct mt_telemetry *)arg;
+    struct timespec wake = t->start_time;
+
+    pthread_mutex_lock(&t->mutex);
+    while (!t->stop_flag)
+    {
+        wake.tv_nsec += MT_TELEMETRY_INTERVAL_MS * 1000000l;
+        if (wake.tv_nsec >= 1000000000l)
+        {
+            wake.tv_sec += 1;
+            wake.tv_nsec -= 1000000000l;
+        }
+        while (!t->stop_flag && pthread_cond_timedwait(&t->cond, &t->mutex, &wake) != ETIMEDOUT)
+        {
+        }
+        // the last sample is taken at stop, so the energy covers the whole window
+        sample(t);
+    }
+    pthread_mutex_unlock(&t->mutex);
+    return NULL;
+}
+
+struct mt_telemetry *mt_telemetry_start(const cpu_set_t *cpus)
+{
+    struct mt_telemetry *t = (struct mt_telemetry *)calloc(1, sizeof(struct mt_telemetry));
+    pthread_condattr_t attr;
+
+    find_cpus(t, cpus);
+    find_zones(t);
+    find_rapl(t);
+    if (!t->cpus && !t->zones && !t->packages)
+    {
+        mt_telemetry_stop(t);
+        return NULL;
+    }
+
+    pthread_mutex_init(&t->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    clock_gettime(CLOCK_MONOTONIC, &t->start_time);
+    sample(t);
+    pthread_create(&t->thread, NULL, telemetry_entry, t);
+    return t;
+}
+
+struct mt_telemetry_result *mt_telemetry_stop(struct mt_telemetry *t)
+{
+    struct mt_telemetry_result *result = NULL;
+    struct timespec end_time;
+
+    if (!t)
+    {
+        return NULL;
+    }
+    if (t->freq_samples)
+    {
+        pthread_mutex_lock(&t->mutex);
+        t->stop_flag = 1;
+        pthread_cond_signal(&t->cond);
+        pthread_mutex_unlock(&t->mutex);
+        pthread_join(t->thread, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end_time);
+        pthread_mutex_destroy(&t->mutex);
+        pthread_cond_destroy(&t->cond);
+
+        result = (struct mt_telemetry_result *)calloc(1, sizeof(struct mt_telemetry_result));
+        result->cpus = t->cpus;
+        result->cpu = t->cpu;
+        result->freq_avg_mhz = (double *)malloc(sizeof(double) * (t->cpus ? t->cpus : 1));
+        result->freq_min_mhz = (double *)malloc(sizeof(double) * (t->cpus ? t->cpus : 1));
+        for (unsigned int i = 0; i < t->cpus; i++)
+        {
+            result->freq_avg_mhz[i] = t->freq_sum_khz[i] / t->freq_samples / 1000;
+            result->freq_min_mhz[i] = t->freq_min_khz[i] / 1000;
+        }
+        result->zones = t->temp_samples ? t->zones : 0;
+        result->temp_min_c = t->temp_min_c;
+        result->temp_max_c = t->temp_max_c;
+        result->packages = t->packages;
+        for (unsigned int i = 0; i < t->packages; i++)
+        {
+            result->energy_j += t->rapl[i].total_uj / 1000000.0;
+        }
+        result->seconds = (end_time.tv_sec - t->start_time.tv_sec) + (end_time.tv_nsec - t->start_time.tv_nsec) / 1000000000.0;
+        t->cpu = NULL;
+    }
+
+    free(t->cpu);
+    free(t->freq_sum_khz);
+    free(t->freq_min_khz);
+    free(t->zone_path);
+    free(t->rapl);
+    free(t);
+    return result;
+}
+
+void mt_telemetry_result_free(struct mt_telemetry_result *result)
+{
+    if (!result)
+    {
+        return;
+    }
+    free(result->cpu);
+    free(result->freq_avg_mhz);
+    free(result->freq_min_mhz);
+    free(result);
+}
+
+void mt_telemetry_print(FILE *f, const struct mt_telemetry_result *result, double ops)
+{
+    for (unsigned int i = 0; i < result->cpus; i++)
+    {
+        fprintf(f, "  cpu %-6d freq(MHz) avg %.0f min %.0f\n", result->cpu[i], result->freq_avg_mhz[i], result->freq_min_mhz[i]);
+    }
+    if (result->zones)
+    {
+        fprintf(f, "  temp(C) min %.1f max %.1f zones %u\n", result->temp_min_c, result->temp_max_c, result->zones);
+    }
+    if (result->packages && result->energy_j > 0)
+    {
+        fprintf(f, "  energy(J) %.2f power(W) %.2f per joule %.2f packages %u\n", result->energy_j,
+                result->energy_j / result->seconds, ops / result->energy_j, result->packages);
+    }
+}
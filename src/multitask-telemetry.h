@@ -0,0 +1,34 @@
+#ifndef __multitask_telemetry_h__
+#define __multitask_telemetry_h__
+
+// users of this header must define _GNU_SOURCE for cpu_set_t
+#include <stdio.h>
+#include <sched.h>
+
+// what the monitor saw during the measured window, sources missing on this machine stay empty
+struct mt_telemetry_result
+{
+    unsigned int cpus;                      // worker cpus with a cpufreq source
+    int *cpu;
+    double *freq_avg_mhz;
+    double *freq_min_mhz;
+    unsigned int zones;                     // thermal zones that could be read
+    double temp_min_c;
+    double temp_max_c;
+    unsigned int packages;                  // rapl package domains that could be read
+    double energy_j;                        // energy of all packages
+    double seconds;                         // length of the monitored window
+};
+
+struct mt_telemetry;
+
+// sample the frequency of cpus, thermal zones and rapl package energy in a background thread,
+// return NULL when none of the sources exists
+struct mt_telemetry *mt_telemetry_start(const cpu_set_t *cpus);
+// stop sampling and return the summary, release it by mt_telemetry_result_free
+struct mt_telemetry_result *mt_telemetry_stop(struct mt_telemetry *telemetry);
+void mt_telemetry_result_free(struct mt_telemetry_result *result);
+// ops is the scaled counter of the measured window, used for ops per joule
+void mt_telemetry_print(FILE *f, const struct mt_telemetry_result *result, double ops);
+
+#endif
@@ -0,0 +1,324 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include "multitask-topology.h"
+
+struct mt_cpu_info
+{
+    int cpu;
+    int package;
+    int core;
+    int node;
+    int smt;                                // index among the hardware threads of one core
+};
+
+static int read_sysfs_int(const char *path, int def)
+{
+    FILE *f = fopen(path, "r");
+    int value;
+
+    if (!f)
+    {
+        return def;
+    }
+    if (fscanf(f, "%d", &value) != 1)
+    {
+        value = def;
+    }
+    fclose(f);
+    return value;
+}
+
+static int cpu_node(int cpu)
+{
+    char path[128];
+    DIR *dir;
+    struct dirent *entry;
+    int node = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    dir = opendir(path);
+    if (!dir)
+    {
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit((unsigned char)entry->d_name[4]))
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+int mt_parse_cpulist(const char *str, cpu_set_t *set)
+{
+    const char *p = str;
+
+    CPU_ZERO(set);
+    while (*p)
+    {
+        char *end;
+        long first, last;
+
+        first = strtol(p, &end, 10);
+        if (end == p || first < 0)
+        {
+            return -1;
+        }
+        last = first;
+        p = end;
+        if (*p == '-')
+        {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first)
+            {
+                return -1;
+            }
+            p = end;
+        }
+        if (last >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            CPU_SET(cpu, set);
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p)
+        {
+            return -1;
+        }
+    }
+    return CPU_COUNT(set) ? 0 : -1;
+}
+
+// package, physical core, hardware thread: neighbours share a core
+static int compare_smt_order(const void *a, const void *b)
+{
+    const struct mt_cpu_info *x = (const struct mt_cpu_info *)a;
+    const struct mt_cpu_info *y = (const struct mt_cpu_info *)b;
+
+    if (x->package != y->package)
+    {
+        return x->package - y->package;
+    }
+    if (x->core != y->core)
+    {
+        return x->core - y->core;
+    }
+    return x->cpu - y->cpu;
+}
+
+// package, hardware thread, physical core: fill all cores of a package before siblings
+static int compare_compact_order(const void *a, const void *b)
+{
+    const struct mt_cpu_info *x = (const struct mt_cpu_info *)a;
+    const struct mt_cpu_info *y = (const struct mt_cpu_info *)b;
+
+    if (x->package != y->package)
+    {
+        return x->package - y->package;
+    }
+    if (x->smt != y->smt)
+    {
+        return x->smt - y->smt;
+    }
+    if (x->core != y->core)
+    {
+        return x->core - y->core;
+    }
+    return x->cpu - y->cpu;
+}
+
+// read the topology of the cpus this process may run on, sorted in smt order
+static size_t read_topology(struct mt_cpu_info **out)
+{
+    cpu_set_t allowed;
+    struct mt_cpu_info *cpus;
+    size_t count = 0;
+    char path[128];
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        perror("sched_getaffinity");
+        abort();
+    }
+
+    cpus = (struct mt_cpu_info *)malloc(sizeof(struct mt_cpu_info) * CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+        {
+            continue;
+        }
+        struct mt_cpu_info *info = &cpus[count++];
+        info->cpu = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        info->package = read_sysfs_int(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        info->core = read_sysfs_int(path, cpu);
+        info->node = cpu_node(cpu);
+        info->smt = 0;
+    }
+
+    qsort(cpus, count, sizeof(struct mt_cpu_info), compare_smt_order);
+    for (size_t i = 1; i < count; i++)
+    {
+        if (cpus[i].package == cpus[i - 1].package && cpus[i].core == cpus[i - 1].core)
+        {
+            cpus[i].smt = cpus[i - 1].smt + 1;
+        }
+    }
+
+    *out = cpus;
+    return count;
+}
+
+static void place_single(struct mt_place *place, const struct mt_cpu_info *info)
+{
+    CPU_ZERO(&place->cpus);
+    CPU_SET(info->cpu, &place->cpus);
+    place->node = info->node;
+}
+
+// round robin over packages, every package walked in compact order
+static size_t plan_scatter(const struct mt_cpu_info *cpus, size_t count, struct mt_place *places)
+{
+    size_t *begin = (size_t *)malloc(sizeof(size_t) * (count + 1));
+    size_t packages = 0;
+    size_t placed = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i == 0 || cpus[i].package != cpus[i - 1].package)
+        {
+            begin[packages++] = i;
+        }
+    }
+    begin[packages] = count;
+
+    for (size_t round = 0; placed < count; round++)
+    {
+        for (size_t p = 0; p < packages; p++)
+        {
+            if (begin[p] + round < begin[p + 1])
+            {
+                place_single(&places[placed++], &cpus[begin[p] + round]);
+            }
+        }
+    }
+    free(begin);
+    return placed;
+}
+
+// every worker may run on all cpus of one node, nodes used round robin
+static size_t plan_numa(const struct mt_cpu_info *cpus, size_t count, struct mt_place *places)
+{
+    size_t nodes = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t n;
+        for (n = 0; n < nodes; n++)
+        {
+            if (places[n].node == cpus[i].node)
+            {
+                break;
+            }
+        }
+        if (n == nodes)
+        {
+            CPU_ZERO(&places[n].cpus);
+            places[n].node = cpus[i].node;
+            nodes++;
+        }
+        CPU_SET(cpus[i].cpu, &places[n].cpus);
+    }
+    return nodes;
+}
+
+unsigned int mt_topology_plan(const char *policy, struct mt_place **places)
+{
+    struct mt_cpu_info *cpus;
+    struct mt_place *result;
+    size_t count;
+    size_t placed = 0;
+
+    count = read_topology(&cpus);
+    result = (struct mt_place *)malloc(sizeof(struct mt_place) * CPU_SETSIZE);
+
+    if (isdigit((unsigned char)policy[0]))
+    {
+        cpu_set_t set;
+        if (mt_parse_cpulist(policy, &set) == 0)
+        {
+            // workers take the listed cpus in increasing order
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                for (size_t i = 0; i < count && CPU_ISSET(cpu, &set); i++)
+                {
+                    if (cpus[i].cpu == cpu)
+                    {
+                        CPU_CLR(cpu, &set);
+                        place_single(&result[placed++], &cpus[i]);
+                    }
+                }
+            }
+            // reject cpus that are offline or not allowed for this process
+            if (CPU_COUNT(&set))
+            {
+                placed = 0;
+            }
+        }
+    }
+    else if (strcmp(policy, "smt") == 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            place_single(&result[placed++], &cpus[i]);
+        }
+    }
+    else if (strcmp(policy, "compact") == 0 || strcmp(policy, "core") == 0)
+    {
+        int core_only = strcmp(policy, "core") == 0;
+        qsort(cpus, count, sizeof(struct mt_cpu_info), compare_compact_order);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (core_only && cpus[i].smt)
+            {
+                continue;
+            }
+            place_single(&result[placed++], &cpus[i]);
+        }
+    }
+    else if (strcmp(policy, "scatter") == 0)
+    {
+        qsort(cpus, count, sizeof(struct mt_cpu_info), compare_compact_order);
+        placed = plan_scatter(cpus, count, result);
+    }
+    else if (strcmp(policy, "numa") == 0)
+    {
+        placed = plan_numa(cpus, count, result);
+    }
+
+    free(cpus);
+    if (!placed)
+    {
+        free(result);
+        return 0;
+    }
+    *places = (struct mt_place *)realloc(result, sizeof(struct mt_place) * placed);
+    return (unsigned int)placed;
+}
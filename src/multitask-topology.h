@@ -0,0 +1,21 @@
+#ifndef __multitask_topology_h__
+#define __multitask_topology_h__
+
+// users of this header must define _GNU_SOURCE for cpu_set_t
+#include <sched.h>
+
+struct mt_place
+{
+    cpu_set_t cpus;                         // cpus the worker is allowed to run on
+    int node;                               // numa node of these cpus, -1 if unknown
+};
+
+// parse a cpu list like "0-3,8,10-11" into set, return 0 on success
+int mt_parse_cpulist(const char *str, cpu_set_t *set);
+
+// build the worker placement list for policy, worker i uses places[i % count]
+// policy: compact, scatter, core, smt, numa or an explicit cpu list
+// return place count, 0 if policy is unknown or no cpu is usable
+unsigned int mt_topology_plan(const char *policy, struct mt_place **places);
+
+#endif
@@ -1,8 +1,486 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <time.h>
+#include <math.h>
 #include "multitask.h"
+#include "multitask-topology.h"
+#include "multitask-stats.h"
+#include "multitask-latency.h"
+#include "multitask-steal.h"
+#include "multitask-perf.h"
+#include "multitask-output.h"
+#include "multitask-telemetry.h"
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#endif
+
+static struct mt_place *mt_places;         // NULL: let the scheduler place workers
+static unsigned int mt_place_count;
+static unsigned int mt_sample_interval_ms;  // 0: sampling disabled
+static unsigned int mt_record_latency;
+static unsigned int mt_runs = 1;
+static unsigned int mt_cooldown;            // seconds to sleep between runs
+static double mt_warmup_cv;                 // percent, 0: adaptive warm-up disabled
+static unsigned int mt_warmup_cap = 30;     // seconds
+static uint32_t mt_fixed_items;             // 0: throughput mode
+static uint32_t mt_fixed_chunk;             // 0: chosen by mt_steal_init
+static unsigned int mt_perf_events;
+static unsigned int mt_telemetry;
+static unsigned int mt_spin_start;          // workers spin on start_fence instead of waiting on cond_m2w
+
+enum
+{
+    MT_OUTPUT_TEXT,
+    MT_OUTPUT_JSON,
+    MT_OUTPUT_CSV,
+};
+static unsigned int mt_output = MT_OUTPUT_TEXT;
+
+// open-loop load: test calls per second of all workers to sweep, 0 while running closed-loop
+static double *mt_open_list;
+static unsigned int mt_open_count;
+static double mt_open_rate;
+static unsigned int mt_open_poisson;
+
+// open-loop workers sleep while the next call is further away than this and spin for the rest
+#define MT_OPEN_SPIN_NS 50000
+#define MT_OPEN_MAX_SLEEP_NS 10000000
+
+// thread counts of -T, in increasing order
+static unsigned int mt_thread_default = 1;
+static unsigned int *mt_thread_list = &mt_thread_default;
+static unsigned int mt_thread_count = 1;
+
+// adaptive warm-up looks at the throughput of the last MT_WARMUP_WINDOWS windows
+#define MT_WARMUP_WINDOW_MS 100
+#define MT_WARMUP_WINDOWS 5
+
+static int compare_unsigned(const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a;
+    unsigned int y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+static int mt_parse_thread_number(const char **p, unsigned long *value)
+{
+    char *end;
+
+    if (**p == 'N' || **p == 'n')
+    {
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        {
+            perror("sched_getaffinity");
+            abort();
+        }
+        *value = CPU_COUNT(&allowed);
+        (*p)++;
+        return 0;
+    }
+    *value = strtoul(*p, &end, 10);
+    if (end == *p)
+    {
+        return -1;
+    }
+    *p = end;
+    return 0;
+}
+
+unsigned int mt_parse_threads(const char *arg)
+{
+    const char *p = arg;
+    unsigned int *list = NULL;
+    unsigned int count = 0;
+    unsigned int unique = 0;
+
+    while (*p)
+    {
+        unsigned long first, last;
+        int doubling = 0;
+
+        if (mt_parse_thread_number(&p, &first) != 0)
+        {
+            goto fail;
+        }
+        last = first;
+        if (p[0] == '.' && p[1] == '.')
+        {
+            p += 2;
+            doubling = 1;
+            if (mt_parse_thread_number(&p, &last) != 0)
+            {
+                goto fail;
+            }
+        }
+        else if (*p == '-')
+        {
+            p++;
+            if (mt_parse_thread_number(&p, &last) != 0)
+            {
+                goto fail;
+            }
+        }
+        if (first == 0 || last < first || last > CPU_SETSIZE * 4)
+        {
+            goto fail;
+        }
+        for (unsigned long t = first; t <= last; t = doubling ? t * 2 : t + 1)
+        {
+            list = (unsigned int *)realloc(list, sizeof(unsigned int) * (count + 2));
+            list[count++] = t;
+            // a doubling range always ends with its upper bound
+            if (doubling && t * 2 > last && t != last)
+            {
+                list[count++] = last;
+            }
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p)
+        {
+            goto fail;
+        }
+    }
+    if (!count)
+    {
+        goto fail;
+    }
+
+    qsort(list, count, sizeof(unsigned int), compare_unsigned);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i == 0 || list[i] != list[unique - 1])
+        {
+            list[unique++] = list[i];
+        }
+    }
+    if (mt_thread_list != &mt_thread_default)
+    {
+        free(mt_thread_list);
+    }
+    mt_thread_list = list;
+    mt_thread_count = unique;
+    return list[unique - 1];
+
+fail:
+    fprintf(stderr, "Invalid thread count: %s\n", arg);
+    exit(EXIT_FAILURE);
+}
+
+// decimal option value between min and max, exit with an error naming what otherwise,
+// strtoul alone would accept "-1" and wrap it around to a huge count
+static unsigned int mt_parse_count(const char *arg, unsigned long min, unsigned long max, const char *what)
+{
+    char *end;
+    unsigned long value;
+
+    errno = 0;
+    value = strtoul(arg, &end, 10);
+    if (!isdigit((unsigned char)arg[0]) || *end || errno || value < min || value > max)
+    {
+        fprintf(stderr, "Invalid %s: %s, need %lu to %lu\n", what, arg, min, max);
+        exit(EXIT_FAILURE);
+    }
+    return (unsigned int)value;
+}
+
+// a decimal number in [min, max], exit on anything else
+static double mt_parse_real(const char *arg, double min, double max, const char *what)
+{
+    char *end;
+    double value;
+
+    errno = 0;
+    value = strtod(arg, &end);
+    if (end == arg || *end || errno || !(value >= min && value <= max))
+    {
+        fprintf(stderr, "Invalid %s: %s, need %g to %g\n", what, arg, min, max);
+        exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+// comma separated rates with an optional k or M suffix, return rate count, 0 on error
+static unsigned int mt_parse_rates(const char *arg, double **rates)
+{
+    const char *p = arg;
+    double *list = NULL;
+    unsigned int count = 0;
+
+    while (*p)
+    {
+        char *end;
+        double rate = strtod(p, &end);
+
+        if (end == p)
+        {
+            break;
+        }
+        if (*end == 'k' || *end == 'K')
+        {
+            rate *= 1000;
+            end++;
+        }
+        else if (*end == 'M')
+        {
+            rate *= 1000000;
+            end++;
+        }
+        if (!(rate > 0) || (*end && *end != ','))
+        {
+            break;
+        }
+        list = (double *)realloc(list, sizeof(double) * (count + 1));
+        list[count++] = rate;
+        p = *end ? end + 1 : end;
+    }
+    if (*p || !count)
+    {
+        free(list);
+        return 0;
+    }
+    free(*rates);
+    *rates = list;
+    return count;
+}
+
+int mt_parse_opt(int opt, const char *arg)
+{
+    switch (opt)
+    {
+    case 'p':
+        free(mt_places);
+        mt_places = NULL;
+        mt_place_count = mt_topology_plan(arg, &mt_places);
+        if (!mt_place_count)
+        {
+            fprintf(stderr, "Invalid pin policy: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        return 1;
+    case 'i':
+        mt_sample_interval_ms = mt_parse_count(arg, 0, 3600000, "sample interval");
+        return 1;
+    case 'l':
+        mt_record_latency = 1;
+        return 1;
+    case 'r':
+        mt_runs = mt_parse_count(arg, 1, 1000, "run count");
+        return 1;
+    case 'c':
+        mt_cooldown = mt_parse_count(arg, 0, 3600, "cool down");
+        return 1;
+    case 'w':
+        mt_warmup_cv = mt_parse_real(arg, 0, 100, "warm-up cv");
+        return 1;
+    case 'W':
+        mt_warmup_cap = mt_parse_count(arg, 1, 3600, "warm-up cap");
+        return 1;
+    case 'e':
+        mt_perf_events = 1;
+        return 1;
+    case 'f':
+        mt_telemetry = 1;
+        return 1;
+    case 'b':
+        mt_spin_start = 1;
+        return 1;
+    case 'R':
+        mt_open_count = mt_parse_rates(arg, &mt_open_list);
+        if (!mt_open_count)
+        {
+            fprintf(stderr, "Invalid open-loop rate: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        return 1;
+    case 'A':
+        if (strcmp(arg, "fixed") == 0 || strcmp(arg, "poisson") == 0)
+        {
+            mt_open_poisson = strcmp(arg, "poisson") == 0;
+            return 1;
+        }
+        fprintf(stderr, "Invalid arrival: %s\n", arg);
+        exit(EXIT_FAILURE);
+    case 'o':
+        if (strcmp(arg, "text") == 0)
+        {
+            mt_output = MT_OUTPUT_TEXT;
+        }
+        else if (strcmp(arg, "json") == 0)
+        {
+            mt_output = MT_OUTPUT_JSON;
+        }
+        else if (strcmp(arg, "csv") == 0)
+        {
+            mt_output = MT_OUTPUT_CSV;
+        }
+        else
+        {
+            fprintf(stderr, "Invalid output format: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        return 1;
+    case 'm':
+        if (mt_alloc_set_policy(arg) != 0)
+        {
+            fprintf(stderr, "Invalid alloc policy: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        return 1;
+    case 's':
+    {
+        char *end;
+        unsigned long items = strtoul(arg, &end, 10);
+        unsigned long chunk = 0;
+        if (*end == ':')
+        {
+            chunk = strtoul(end + 1, &end, 10);
+        }
+        if (*end || items == 0 || items > UINT32_MAX || chunk > UINT32_MAX)
+        {
+            fprintf(stderr, "Invalid fixed work: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        mt_fixed_items = (uint32_t)items;
+        mt_fixed_chunk = (uint32_t)chunk;
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+void mt_usage_opts(FILE *f)
+{
+    fprintf(f, "  -p <policy>   Pin workers: compact, scatter, core, smt, numa or a cpu list like 0-3,8\n"
+                "  -i <ms>       Sample worker counters every ms and report per worker and per interval rates\n"
+                "  -l            Record the latency of every test call and report percentiles\n"
+                "  -r <runs>     Repeat every case and report median, mean, stddev and 95%% confidence interval\n"
+                "  -c <seconds>  Cool down between repeated runs\n"
+                "  -w <cv>       Warm up until the throughput coefficient of variation drops below cv percent\n"
+                "  -W <seconds>  Give up adaptive warm-up after seconds, default 30\n"
+                "  -m <policy>   Page policy of test memory: default, 4k, thp, 2m, 1g or interleave\n"
+                "  -e            Count cycles, instructions, cache, branch and TLB misses per worker with perf events\n"
+                "  -b            Workers spin at the start barrier instead of sleeping, use only with a cpu per worker\n"
+                "  -f            Monitor cpu frequency, thermal zones and rapl energy, report ops per joule\n"
+                "  -R <rates>    Open loop: also start test calls at each total rate like 1000,5k,1M per second\n"
+                "                and report latency from the scheduled start against load\n"
+                "  -A <arrival>  Open-loop schedule: fixed (default) or poisson\n"
+                "  -o <format>   Output format: text, json (one object per case and line) or csv (one row per run)\n"
+                "  -s <items>[:<chunk>]\n"
+                "                Strong scaling: share a fixed number of test calls with work stealing,\n"
+                "                report time to completion, speedup and efficiency against 1 worker\n"
+                "Cases joined like A:2+B:2 run at the same time on separate workers, every case alone\n"
+                "and next to the others, and report the slowdown of each\n");
+}
+
+int mt_output_text(void)
+{
+    return mt_output == MT_OUTPUT_TEXT;
+}
+
+unsigned int mt_run_count(void)
+{
+    return mt_runs;
+}
+
+int mt_placed(void)
+{
+    return mt_places != NULL;
+}
+
+void mt_bind_worker(unsigned int index)
+{
+    const struct mt_place *place;
+    int err;
+
+    if (!mt_places)
+    {
+        return;
+    }
+    place = &mt_places[index % mt_place_count];
+    err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &place->cpus);
+    if (err)
+    {
+        fprintf(stderr, "pthread_setaffinity_np failed: %s\n", strerror(err));
+        abort();
+    }
+#ifdef HAVE_NUMA
+    if (place->node >= 0 && numa_available() >= 0)
+    {
+        numa_set_preferred(place->node);
+    }
+#endif
+}
+
+static __thread cpu_set_t mt_node_saved;    // affinity before mt_bind_node
+static __thread int mt_node_bound;
+
+int mt_bind_node(int node)
+{
+#ifdef HAVE_NUMA
+    struct bitmask *mask;
+    cpu_set_t cpus;
+    int err;
+
+    if (numa_available() < 0)
+    {
+        return -1;
+    }
+    mask = numa_allocate_cpumask();
+    if (numa_node_to_cpus(node, mask) != 0)
+    {
+        numa_free_cpumask(mask);
+        return -1;
+    }
+    CPU_ZERO(&cpus);
+    for (unsigned int cpu = 0; cpu < mask->size && cpu < CPU_SETSIZE; cpu++)
+    {
+        if (numa_bitmask_isbitset(mask, cpu) && numa_bitmask_isbitset(numa_all_cpus_ptr, cpu))
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    numa_free_cpumask(mask);
+    if (!CPU_COUNT(&cpus))
+    {
+        return -1;
+    }
+    if (!mt_node_bound)
+    {
+        pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &mt_node_saved);
+        mt_node_bound = 1;
+    }
+    err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+    if (err)
+    {
+        fprintf(stderr, "pthread_setaffinity_np failed: %s\n", strerror(err));
+        abort();
+    }
+    return 0;
+#else
+    (void)node;
+    return -1;
+#endif
+}
+
+void mt_unbind_node(void)
+{
+    if (mt_node_bound)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mt_node_saved);
+        mt_node_bound = 0;
+    }
+}
 
 void mt_shared_init(struct mt_shared *shared)
 {
@@ -19,76 +497,1036 @@ void mt_shared_destroy(struct mt_shared *shared)
     pthread_cond_destroy(&shared->cond_w2m);
 }
 
-static void *mt_worker_entry(void *arg)
+struct mt_data *mt_data_new(struct mt_shared *shared, unsigned int tasks)
+{
+    size_t size = sizeof(struct mt_data) * tasks;
+    struct mt_data *data_list = (struct mt_data *)aligned_alloc(MT_CACHELINE_SIZE, size);
+
+    if (!data_list)
+    {
+        fprintf(stderr, "aligned_alloc(%zu) failed\n", size);
+        abort();
+    }
+    memset(data_list, 0, size);
+    for (unsigned int i = 0; i < tasks; i++)
+    {
+        data_list[i].shared = shared;
+    }
+    return data_list;
+}
+
+void mt_data_delete(struct mt_data *data_list)
+{
+    free(data_list);
+}
+
+void mt_result_free(struct mt_result *result)
+{
+    free(result->worker_counter);
+    free(result->interval_ns);
+    free(result->interval_counter);
+    free(result->worker_finish_ns);
+    free(result->worker_active_ns);
+    free(result->perf);
+    mt_telemetry_result_free(result->telemetry);
+    mt_histogram_delete(result->latency);
+    memset(result, 0, sizeof(struct mt_result));
+}
+
+void mt_result_print(FILE *f, const struct mt_result *result, double scale)
+{
+    unsigned int workers = result->workers;
+    unsigned int intervals = result->intervals;
+    double *rates;
+    struct mt_stats stats;
+    double elapsed_end = 0;
+
+    if (mt_alloc_get_policy() != MT_ALLOC_DEFAULT)
+    {
+        fprintf(f, "  alloc requested %s effective", mt_alloc_policy_name(mt_alloc_get_policy()));
+        for (unsigned int i = 0; i < MT_ALLOC_POLICY_COUNT; i++)
+        {
+            if (result->alloc_effective & (1u << i))
+            {
+                fprintf(f, " %s", mt_alloc_policy_name(i));
+            }
+        }
+        fprintf(f, "\n");
+    }
+
+    if (result->warmup_ns)
+    {
+        fprintf(f, "  warmup %.2fs %s cv %.2f%%\n", result->warmup_ns / 1000000000.0,
+                result->warmup_steady ? "steady" : "not steady", result->warmup_cv);
+    }
+
+    if (result->fixed_items)
+    {
+        double speedup = result->serial_ns ? (double)result->serial_ns / result->elapsed_ns : 1.0;
+        uint64_t first = UINT64_MAX, last = 0;
+
+        for (unsigned int w = 0; w < workers; w++)
+        {
+            first = result->worker_finish_ns[w] < first ? result->worker_finish_ns[w] : first;
+            last = result->worker_finish_ns[w] > last ? result->worker_finish_ns[w] : last;
+        }
+        fprintf(f, "  fixed %llu items %.3fs serial %.3fs speedup %.2f efficiency %.2f finish spread %.3fms\n",
+                (unsigned long long)result->fixed_items, result->elapsed_ns / 1000000000.0,
+                result->serial_ns / 1000000000.0, speedup, speedup / workers, (last - first) / 1000000.0);
+    }
+
+    if (result->perf)
+    {
+        if (result->perf->valid)
+        {
+            mt_perf_print(f, result->perf, result->counter, result->unit);
+        }
+        else
+        {
+            fprintf(f, "  perf unavailable\n");
+        }
+    }
+
+    if (result->telemetry)
+    {
+        mt_telemetry_print(f, result->telemetry, result->counter * scale);
+    }
+    else if (mt_telemetry)
+    {
+        fprintf(f, "  telemetry unavailable\n");
+    }
+
+    if (result->latency && result->latency->count)
+    {
+        const struct mt_histogram *hist = result->latency;
+        double ns_per_tick = 1.0 / mt_ticks_per_ns();
+
+        fprintf(f, "  latency(ns) p50 %.0f p90 %.0f p99 %.0f p99.9 %.0f max %.0f samples %llu\n",
+                mt_histogram_percentile(hist, 50) * ns_per_tick,
+                mt_histogram_percentile(hist, 90) * ns_per_tick,
+                mt_histogram_percentile(hist, 99) * ns_per_tick,
+                mt_histogram_percentile(hist, 99.9) * ns_per_tick,
+                hist->max * ns_per_tick,
+                (unsigned long long)hist->count);
+    }
+
+    if (!intervals)
+    {
+        return;
+    }
+
+    rates = (double *)calloc(workers > intervals ? workers : intervals, sizeof(double));
+    for (unsigned int w = 0; w < workers; w++)
+    {
+        if (result->worker_active_ns[w])
+        {
+            rates[w] = result->worker_counter[w] / (result->worker_active_ns[w] / 1000000000.0) * scale;
+        }
+    }
+    mt_stats_compute(rates, workers, &stats);
+    fprintf(f, "  workers     min %.2f max %.2f stddev %.2f fairness %.4f\n",
+            stats.min, stats.max, stats.stddev, mt_stats_fairness(rates, workers));
+    fprintf(f, "  window      start skew %.3fms stop skew %.3fms overlap %.3fs\n", result->start_skew_ns / 1000000.0,
+            result->stop_skew_ns / 1000000.0, result->overlap_ns / 1000000000.0);
+    for (unsigned int w = 0; w < workers; w++)
+    {
+        fprintf(f, "  worker %-4u %.2f active %.3fs\n", w, rates[w], result->worker_active_ns[w] / 1000000000.0);
+    }
+
+    for (unsigned int i = 0; i < intervals; i++)
+    {
+        uint64_t counter = 0;
+        for (unsigned int w = 0; w < workers; w++)
+        {
+            counter += result->interval_counter[i * workers + w];
+        }
+        rates[i] = counter / (result->interval_ns[i] / 1000000000.0) * scale;
+    }
+    mt_stats_compute(rates, intervals, &stats);
+    fprintf(f, "  intervals   min %.2f max %.2f stddev %.2f\n", stats.min, stats.max, stats.stddev);
+    for (unsigned int i = 0; i < intervals; i++)
+    {
+        double seconds = result->interval_ns[i] / 1000000000.0;
+        double worker_min = 0, worker_max = 0;
+
+        for (unsigned int w = 0; w < workers; w++)
+        {
+            double rate = result->interval_counter[i * workers + w] / seconds * scale;
+            if (w == 0 || rate < worker_min)
+            {
+                worker_min = rate;
+            }
+            if (w == 0 || rate > worker_max)
+            {
+                worker_max = rate;
+            }
+        }
+        elapsed_end += seconds;
+        fprintf(f, "  %9.3fs  %.2f worker min %.2f max %.2f\n", elapsed_end, rates[i], worker_min, worker_max);
+    }
+    free(rates);
+}
+
+// run a case -r times with tasks workers and print it, label names the case in text output,
+// return the median rate, load is optional and collects the latency of all runs
+static double mt_run_case_tasks(const char *name, const char *label, mt_case_func run, const void *arg,
+                                double scale, unsigned int tasks, struct mt_load_point *load)
+{
+    double *rates = (double *)malloc(sizeof(double) * mt_runs);
+    int *outlier = (int *)calloc(mt_runs, sizeof(int));
+    struct mt_result *results = (struct mt_result *)calloc(mt_runs, sizeof(struct mt_result));
+    struct mt_stats stats;
+    size_t outliers = 0;
+
+    for (unsigned int i = 0; i < mt_runs; i++)
+    {
+        if (i && mt_cooldown)
+        {
+            sleep(mt_cooldown);
+        }
+        rates[i] = run(arg, tasks, &results[i]);
+    }
+    mt_stats_compute(rates, mt_runs, &stats);
+    if (mt_runs > 1)
+    {
+        outliers = mt_stats_outliers(rates, mt_runs, outlier);
+    }
+
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_json(stdout, name, results, rates, outlier, mt_runs, &stats, scale);
+    }
+    else if (mt_output == MT_OUTPUT_CSV)
+    {
+        mt_output_csv(stdout, name, results, rates, outlier, mt_runs, scale);
+    }
+    else if (mt_runs == 1)
+    {
+        printf("%-20s%.2f\n", label, rates[0]);
+        mt_result_print(stdout, &results[0], scale);
+    }
+    else
+    {
+        // details of every run are printed after the summary line
+        printf("%-20s%.2f\n", label, stats.median);
+        printf("  runs %u median %.2f mean %.2f best %.2f worst %.2f stddev %.2f ci95 %.2f outliers %zu\n",
+               mt_runs, stats.median, stats.mean, stats.max, stats.min, stats.stddev, stats.ci95, outliers);
+        for (unsigned int i = 0; i < mt_runs; i++)
+        {
+            printf("  run %-8u%.2f%s\n", i, rates[i], outlier[i] ? " outlier" : "");
+            mt_result_print(stdout, &results[i], scale);
+        }
+    }
+
+    for (unsigned int i = 0; i < mt_runs; i++)
+    {
+        if (load && results[i].latency)
+        {
+            mt_histogram_merge(load->latency, results[i].latency);
+            load->calls += results[i].latency->count;
+            load->elapsed_ns += results[i].elapsed_ns;
+        }
+        mt_result_free(&results[i]);
+    }
+    free(results);
+    free(rates);
+    free(outlier);
+    return stats.median;
+}
+
+// open-loop sweep of one case with tasks workers, label names the case in text output
+static void mt_run_load(const char *name, const char *label, mt_case_func run, const void *arg,
+                        double scale, unsigned int tasks)
+{
+    struct mt_load_point *points = (struct mt_load_point *)calloc(mt_open_count, sizeof(struct mt_load_point));
+    double ns_per_tick = 1.0 / mt_ticks_per_ns();
+
+    for (unsigned int i = 0; i < mt_open_count; i++)
+    {
+        char open_name[128], open_label[128];
+
+        snprintf(open_name, sizeof(open_name), "%s@%g", name, mt_open_list[i]);
+        snprintf(open_label, sizeof(open_label), "%s@%g", label, mt_open_list[i]);
+        points[i].target = mt_open_list[i];
+        points[i].latency = mt_histogram_new();
+        mt_open_rate = mt_open_list[i];
+        mt_run_case_tasks(open_name, open_label, run, arg, scale, tasks, &points[i]);
+        mt_open_rate = 0;
+    }
+
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_load_json(stdout, name, tasks, mt_open_poisson ? "poisson" : "fixed", points, mt_open_count);
+    }
+    else if (mt_output == MT_OUTPUT_TEXT)
+    {
+        printf("%s open loop, %s arrival\n", label, mt_open_poisson ? "poisson" : "fixed");
+        printf("  %-12s%-12s%-12s%-12s%-12s%-12s%s\n", "target/s", "achieved/s", "p50(ns)", "p90", "p99", "p99.9", "max");
+        for (unsigned int i = 0; i < mt_open_count; i++)
+        {
+            const struct mt_histogram *hist = points[i].latency;
+            double achieved = points[i].elapsed_ns ? points[i].calls / (points[i].elapsed_ns / 1000000000.0) : 0;
+
+            printf("  %-12.0f%-12.0f%-12.0f%-12.0f%-12.0f%-12.0f%.0f\n", points[i].target, achieved,
+                   mt_histogram_percentile(hist, 50) * ns_per_tick, mt_histogram_percentile(hist, 90) * ns_per_tick,
+                   mt_histogram_percentile(hist, 99) * ns_per_tick, mt_histogram_percentile(hist, 99.9) * ns_per_tick,
+                   hist->count ? hist->max * ns_per_tick : 0);
+        }
+    }
+    // csv rows of every target already carry the latency percentiles
+
+    for (unsigned int i = 0; i < mt_open_count; i++)
+    {
+        mt_histogram_delete(points[i].latency);
+    }
+    free(points);
+}
+
+double mt_run_case_at(const char *name, mt_case_func run, const void *arg, double scale, unsigned int tasks)
+{
+    char label[64];
+
+    // calibrate before workers read it
+    mt_ticks_per_ns();
+    // text lines tell the thread counts apart like the lines of a -T list sweep
+    if (mt_thread_count > 1)
+    {
+        snprintf(label, sizeof(label), "%s:%u", name, tasks);
+    }
+    else
+    {
+        snprintf(label, sizeof(label), "%s", name);
+    }
+    return mt_run_case_tasks(name, label, run, arg, scale, tasks, NULL);
+}
+
+unsigned int mt_thread_counts(const unsigned int **list)
+{
+    *list = mt_thread_list;
+    return mt_thread_count;
+}
+
+void mt_run_case(const char *name, mt_case_func run, const void *arg, double scale)
+{
+    mt_run_case_rates(name, run, arg, scale, NULL);
+}
+
+void mt_run_case_rates(const char *name, mt_case_func run, const void *arg, double scale, double *median)
+{
+    double *threads, *rates, *speedup;
+    struct mt_scaling scaling;
+    double base;
+
+    if (mt_open_count && mt_fixed_items)
+    {
+        fprintf(stderr, "Open-loop rates cannot be combined with fixed work\n");
+        exit(EXIT_FAILURE);
+    }
+    // calibrate before workers read it
+    mt_ticks_per_ns();
+
+    if (mt_thread_count == 1)
+    {
+        double rate = mt_run_case_tasks(name, name, run, arg, scale, mt_thread_list[0], NULL);
+        if (median)
+        {
+            median[0] = rate;
+        }
+        if (mt_open_count)
+        {
+            mt_run_load(name, name, run, arg, scale, mt_thread_list[0]);
+        }
+        return;
+    }
+
+    threads = (double *)malloc(sizeof(double) * mt_thread_count);
+    rates = (double *)malloc(sizeof(double) * mt_thread_count);
+    speedup = (double *)malloc(sizeof(double) * mt_thread_count);
+    for (unsigned int i = 0; i < mt_thread_count; i++)
+    {
+        char label[64];
+        snprintf(label, sizeof(label), "%s:%u", name, mt_thread_list[i]);
+        threads[i] = mt_thread_list[i];
+        rates[i] = mt_run_case_tasks(name, label, run, arg, scale, mt_thread_list[i], NULL);
+        if (median)
+        {
+            median[i] = rates[i];
+        }
+        if (mt_open_count)
+        {
+            mt_run_load(name, label, run, arg, scale, mt_thread_list[i]);
+        }
+    }
+
+    // without a 1 thread point the smallest count is assumed to scale linearly
+    base = rates[0] / threads[0];
+    for (unsigned int i = 0; i < mt_thread_count; i++)
+    {
+        speedup[i] = base > 0 ? rates[i] / base : 0;
+    }
+    mt_stats_scaling(threads, speedup, mt_thread_count, &scaling);
+
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_sweep_json(stdout, name, threads, rates, speedup, mt_thread_count, &scaling);
+    }
+    else if (mt_output == MT_OUTPUT_TEXT)
+    {
+        printf("%s scaling\n", name);
+        printf("  %-10s%-14s%-10s%s\n", "threads", "rate", "speedup", "efficiency");
+        for (unsigned int i = 0; i < mt_thread_count; i++)
+        {
+            printf("  %-10u%-14.2f%-10.2f%.1f%%%s\n", mt_thread_list[i], rates[i], speedup[i],
+                   speedup[i] / threads[i] * 100, i == scaling.knee ? " knee" : "");
+        }
+        printf("  amdahl serial %.2f%% max speedup ", scaling.amdahl_serial * 100);
+        if (scaling.amdahl_serial > 0)
+        {
+            printf("%.2f\n", 1 / scaling.amdahl_serial);
+        }
+        else
+        {
+            printf("unbounded\n");
+        }
+        printf("  usl sigma %.4f kappa %.6f peak ", scaling.usl_sigma, scaling.usl_kappa);
+        if (scaling.usl_peak > 0)
+        {
+            printf("%.0f threads\n", scaling.usl_peak);
+        }
+        else
+        {
+            printf("unbounded\n");
+        }
+    }
+    // csv rows already carry the thread count, the summary is left to the reader
+
+    free(threads);
+    free(rates);
+    free(speedup);
+}
+
+void mt_format_size(char *buf, size_t len, size_t size)
+{
+    if (size && size % (1ull << 30) == 0)
+    {
+        snprintf(buf, len, "%zuG", size >> 30);
+    }
+    else if (size && size % (1ull << 20) == 0)
+    {
+        snprintf(buf, len, "%zuM", size >> 20);
+    }
+    else if (size && size % (1ull << 10) == 0)
+    {
+        snprintf(buf, len, "%zuK", size >> 10);
+    }
+    else
+    {
+        snprintf(buf, len, "%zu", size);
+    }
+}
+
+static void report_matrix(const char *name, const char *title, const char *unit, const char *const *rows,
+                          unsigned int row_count, const char *const *cols, unsigned int col_count,
+                          const double *values, int cell_rows)
+{
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_matrix_json(stdout, name, title, unit, rows, row_count, cols, col_count, values);
+        return;
+    }
+    if (mt_output == MT_OUTPUT_CSV)
+    {
+        if (cell_rows)
+        {
+            mt_output_matrix_csv(stdout, name, rows, row_count, cols, col_count, values);
+        }
+        return;
+    }
+    // the row names column fits the longest name
+    int width = 12;
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        if ((int)strlen(rows[r]) + 2 > width)
+        {
+            width = (int)strlen(rows[r]) + 2;
+        }
+    }
+    printf("%s %s, %s\n", name, title, unit);
+    printf("  %-*s", width, "");
+    for (unsigned int c = 0; c < col_count; c++)
+    {
+        printf("%-14s", cols[c]);
+    }
+    printf("\n");
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        printf("  %-*s", width, rows[r]);
+        for (unsigned int c = 0; c < col_count; c++)
+        {
+            printf("%-14.2f", values[r * col_count + c]);
+        }
+        printf("\n");
+    }
+}
+
+void mt_report_matrix(const char *name, const char *title, const char *unit, const char *const *rows,
+                      unsigned int row_count, const char *const *cols, unsigned int col_count, const double *values)
+{
+    // csv rows of every cell are already printed
+    report_matrix(name, title, unit, rows, row_count, cols, col_count, values, 0);
+}
+
+void mt_report_matrix_cells(const char *name, const char *title, const char *unit, const char *const *rows,
+                            unsigned int row_count, const char *const *cols, unsigned int col_count,
+                            const double *values)
+{
+    report_matrix(name, title, unit, rows, row_count, cols, col_count, values, 1);
+}
+
+void mt_report_sizes(const char *name, const char *unit, const size_t *sizes, unsigned int count, const double *rates)
+{
+    char label[32];
+
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_size_json(stdout, name, mt_thread_list, mt_thread_count, sizes, count, rates);
+        return;
+    }
+    // csv rows of every size already carry the size in their name
+    if (mt_output != MT_OUTPUT_TEXT)
+    {
+        return;
+    }
+    printf("%s working set per thread, %s\n", name, unit);
+    printf("  %-10s", "size");
+    for (unsigned int t = 0; t < mt_thread_count; t++)
+    {
+        snprintf(label, sizeof(label), "T=%u", mt_thread_list[t]);
+        printf("%-14s", label);
+    }
+    printf("\n");
+    for (unsigned int i = 0; i < count; i++)
+    {
+        mt_format_size(label, sizeof(label), sizes[i]);
+        printf("  %-10s", label);
+        for (unsigned int t = 0; t < mt_thread_count; t++)
+        {
+            printf("%-14.2f", rates[i * mt_thread_count + t]);
+        }
+        printf("\n");
+    }
+}
+
+static uint64_t timespec_diff_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000ull + end->tv_nsec - start->tv_nsec;
+}
+
+// sleep for duration seconds, snapshot all worker counters every mt_sample_interval_ms
+static void mt_sample(struct mt_data *data_list, unsigned int tasks, unsigned int duration,
+                      const struct timespec *start_time, const uint64_t *baseline, struct mt_result *result)
+{
+    uint64_t interval_ns = mt_sample_interval_ms * 1000000ull;
+    uint64_t duration_ns = duration * 1000000000ull;
+    unsigned int max_intervals = (duration_ns + interval_ns - 1) / interval_ns;
+    uint64_t *last = (uint64_t *)malloc(sizeof(uint64_t) * tasks);
+    struct timespec last_time = *start_time;
+    uint64_t deadline = 0;
+
+    result->interval_ns = (uint64_t *)malloc(sizeof(uint64_t) * max_intervals);
+    result->interval_counter = (uint64_t *)malloc(sizeof(uint64_t) * max_intervals * tasks);
+    result->intervals = 0;
+    memcpy(last, baseline, sizeof(uint64_t) * tasks);
+
+    while (deadline < duration_ns)
+    {
+        struct timespec wake, now;
+        unsigned int i = result->intervals;
+
+        deadline += interval_ns;
+        if (deadline > duration_ns)
+        {
+            deadline = duration_ns;
+        }
+        wake.tv_sec = start_time->tv_sec + (start_time->tv_nsec + deadline) / 1000000000;
+        wake.tv_nsec = (start_time->tv_nsec + deadline) % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR)
+        {
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (unsigned int w = 0; w < tasks; w++)
+        {
+            uint64_t counter = __atomic_load_n(&data_list[w].counter, __ATOMIC_RELAXED);
+            result->interval_counter[i * tasks + w] = counter - last[w];
+            last[w] = counter;
+        }
+        result->interval_ns[i] = timespec_diff_ns(&last_time, &now);
+        result->intervals++;
+        last_time = now;
+    }
+    free(last);
+}
+
+static void mt_snapshot(const struct mt_data *data_list, unsigned int tasks, uint64_t *counters)
+{
+    for (unsigned int i = 0; i < tasks; i++)
+    {
+        counters[i] = __atomic_load_n(&data_list[i].counter, __ATOMIC_RELAXED);
+    }
+}
+
+// keep workers running in short windows until the throughput of the last windows is steady
+// or mt_warmup_cap is reached, then restart the clock and counters from there
+static void mt_steady_warmup(struct mt_data *data_list, unsigned int tasks, struct timespec *start_time,
+                             uint64_t *baseline, struct mt_result *result)
+{
+    const struct timespec window = { 0, MT_WARMUP_WINDOW_MS * 1000000l };
+    double rates[MT_WARMUP_WINDOWS];
+    unsigned int windows = 0;
+    struct timespec last_time = *start_time, now;
+    uint64_t last = 0, elapsed;
+    struct mt_stats stats = { 0 };
+    unsigned int steady = 0;
+
+    mt_snapshot(data_list, tasks, baseline);
+    for (unsigned int i = 0; i < tasks; i++)
+    {
+        last += baseline[i];
+    }
+
+    while (1)
+    {
+        uint64_t counter = 0;
+
+        nanosleep(&window, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        mt_snapshot(data_list, tasks, baseline);
+        for (unsigned int i = 0; i < tasks; i++)
+        {
+            counter += baseline[i];
+        }
+        rates[windows++ % MT_WARMUP_WINDOWS] = (counter - last) / (timespec_diff_ns(&last_time, &now) / 1000000000.0);
+        last = counter;
+        last_time = now;
+        elapsed = timespec_diff_ns(start_time, &now);
+
+        if (windows >= MT_WARMUP_WINDOWS)
+        {
+            mt_stats_compute(rates, MT_WARMUP_WINDOWS, &stats);
+            if (stats.mean > 0 && stats.stddev / stats.mean * 100 < mt_warmup_cv)
+            {
+                steady = 1;
+                break;
+            }
+        }
+        if (elapsed >= mt_warmup_cap * 1000000000ull)
+        {
+            break;
+        }
+    }
+
+    *start_time = now;
+    if (result)
+    {
+        result->warmup_ns = elapsed;
+        result->warmup_steady = steady;
+        result->warmup_cv = stats.mean > 0 ? stats.stddev / stats.mean * 100 : 0;
+    }
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// mixed mode: every group has its own shared for ops and userdata, the first one synchronizes
+static struct mt_shared *mt_sync_shared(const struct mt_data *data)
+{
+    return data->shared->leader ? data->shared->leader : data->shared;
+}
+
+// fixed-work mode: run ops->test once per item until no item is left
+static void mt_worker_fixed(struct mt_data *data)
+{
+    struct mt_shared *shared = mt_sync_shared(data);
+    const struct mt_test_ops *ops = data->shared->ops;
+    uint32_t begin, end;
+
+    while (mt_steal_next(shared->steal, data->index, &begin, &end))
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (data->latency)
+            {
+                uint64_t start = mt_ticks();
+                ops->test(data);
+                mt_histogram_record(data->latency, mt_ticks() - start);
+            }
+            else
+            {
+                ops->test(data);
+            }
+        }
+    }
+}
+
+// open-loop mode: start ops->test on a fixed-rate or poisson schedule until stop_flag is set,
+// latency counts from the scheduled start, so a call that waited behind a slow one is charged for it
+static void mt_worker_open(struct mt_data *data, const struct mt_shared *shared)
+{
+    const struct mt_test_ops *ops = data->shared->ops;
+    double ticks_per_ns = mt_ticks_per_ns();
+    double interval = ticks_per_ns * 1000000000.0 / (mt_open_rate / shared->workers);
+    uint64_t state = 0x9e3779b97f4a7c15ull * (data->index + 1);
+    // fixed-rate workers are staggered so that all calls together are evenly spaced
+    double next = mt_ticks() + (mt_open_poisson ? 0 : interval * data->index / shared->workers);
+
+    while (1)
+    {
+        uint64_t now;
+        uint64_t scheduled = (uint64_t)next;
+
+        while ((now = mt_ticks()) < scheduled && !shared->stop_flag)
+        {
+            double wait_ns = (scheduled - now) / ticks_per_ns;
+            if (wait_ns > MT_OPEN_SPIN_NS)
+            {
+                double sleep_ns = fmin(wait_ns - MT_OPEN_SPIN_NS, MT_OPEN_MAX_SLEEP_NS);
+                struct timespec pause = { 0, (long)sleep_ns };
+                nanosleep(&pause, NULL);
+            }
+        }
+        if (shared->stop_flag)
+        {
+            break;
+        }
+
+        ops->test(data);
+        mt_histogram_record(data->latency, mt_ticks() - scheduled);
+
+        if (mt_open_poisson)
+        {
+            // exponential gaps, uniform from the top 53 bits of xorshift64 in (0, 1]
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            next += -log(((state >> 11) + 1) * (1.0 / 9007199254740992.0)) * interval;
+        }
+        else
+        {
+            next += interval;
+        }
+    }
+}
+
+// run one case on the calling thread, from prepare to clean
+static void mt_worker_run(struct mt_data *data)
+{
+    struct mt_shared *shared = mt_sync_shared(data);
+    const struct mt_test_ops *ops = data->shared->ops;
+
+    if (mt_record_latency || mt_open_rate)
+    {
+        data->latency = mt_histogram_new();
+    }
+
+    // prepare
+    if (ops->prepare)
+    {
+        ops->prepare(data);
+    }
+    if (mt_perf_events)
+    {
+        data->perf = mt_perf_open();
+    }
+
+    // warmup
+    if (ops->warmup)
+    {
+        ops->warmup(data);
+    }
+
+    // notify main thread that worker thread is ready
+    pthread_mutex_lock(&shared->mutex);
+    shared->worker_count += 1;
+    if (shared->worker_count == shared->workers)
+    {
+        pthread_cond_signal(&shared->cond_w2m);
+    }
+    pthread_mutex_unlock(&shared->mutex);
+
+    // wait for start
+    if (mt_spin_start)
+    {
+        while (!__atomic_load_n(&shared->start_fence, __ATOMIC_ACQUIRE))
+        {
+            mt_cpu_relax();
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&shared->mutex);
+        while (!shared->start_fence)
+        {
+            pthread_cond_wait(&shared->cond_m2w, &shared->mutex);
+        }
+        pthread_mutex_unlock(&shared->mutex);
+    }
+
+    // adaptive warm-up: run until the main thread begins the measured window
+    while (!shared->measure_flag && !shared->stop_flag)
+    {
+        ops->test(data);
+    }
+
+    // the measured window of this worker begins with its first measured call
+    data->start_counter = data->counter;
+    data->start_ns = monotonic_ns();
+    if (data->perf)
+    {
+        mt_perf_start(data->perf);
+    }
+    if (shared->steal)
+    {
+        mt_worker_fixed(data);
+    }
+    else if (mt_open_rate)
+    {
+        mt_worker_open(data, shared);
+    }
+    // run test until stop_flag is set
+    else if (data->latency)
+    {
+        while (!shared->stop_flag)
+        {
+            uint64_t start = mt_ticks();
+            ops->test(data);
+            mt_histogram_record(data->latency, mt_ticks() - start);
+        }
+    }
+    else
+    {
+        while (!shared->stop_flag)
+        {
+            ops->test(data);
+        }
+    }
+    data->stop_ns = monotonic_ns();
+    if (data->perf)
+    {
+        mt_perf_stop(data->perf);
+    }
+
+    // notify main thread that worker thread is stopped
+    pthread_mutex_lock(&shared->mutex);
+    shared->worker_count -= 1;
+    if (shared->worker_count == 0)
+    {
+        pthread_cond_signal(&shared->cond_w2m);
+    }
+    pthread_mutex_unlock(&shared->mutex);
+
+    if (ops->clean)
+    {
+        ops->clean(data);
+    }
+}
+
+static void *mt_worker_entry(void *arg)
+{
+    struct mt_data *data = (struct mt_data *)arg;
+
+    // pin before prepare so that worker memory is allocated on the local node
+    mt_bind_worker(data->index);
+    mt_worker_run(data);
+    return NULL;
+}
+
+struct mt_pool_thread
+{
+    struct mt_pool *pool;
+    unsigned int index;
+    pthread_t thread;
+};
+
+struct mt_pool
+{
+    unsigned int workers;
+    pthread_mutex_t mutex;                  // protect all fields below
+    pthread_cond_t cond_job;                // main thread to pool threads: new job or exit
+    pthread_cond_t cond_done;               // pool threads to main thread: job finished
+    unsigned int generation;                // incremented for every job
+    unsigned int exit_flag;
+    struct mt_data *job;                    // data list of the current job
+    unsigned int job_tasks;                 // pool threads with index < job_tasks take part
+    unsigned int done;
+    struct mt_pool_thread *threads;
+};
+
+static void *mt_pool_entry(void *arg)
+{
+    struct mt_pool_thread *self = (struct mt_pool_thread *)arg;
+    struct mt_pool *pool = self->pool;
+    unsigned int generation = 0;
+
+    // pinned once, placement survives across jobs
+    mt_bind_worker(self->index);
+
+    while (1)
+    {
+        struct mt_data *job;
+        unsigned int tasks;
+
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->generation == generation && !pool->exit_flag)
+        {
+            pthread_cond_wait(&pool->cond_job, &pool->mutex);
+        }
+        if (pool->exit_flag)
+        {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        generation = pool->generation;
+        job = pool->job;
+        tasks = pool->job_tasks;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (self->index >= tasks)
+        {
+            continue;
+        }
+        mt_worker_run(&job[self->index]);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->done += 1;
+        if (pool->done == pool->job_tasks)
+        {
+            pthread_cond_signal(&pool->cond_done);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return NULL;
+}
+
+struct mt_pool *mt_pool_new(unsigned int workers)
+{
+    struct mt_pool *pool = (struct mt_pool *)calloc(1, sizeof(struct mt_pool));
+
+    if (!workers)
+    {
+        fprintf(stderr, "workers cannot be 0\n");
+        abort();
+    }
+    pool->workers = workers;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond_job, NULL);
+    pthread_cond_init(&pool->cond_done, NULL);
+    pool->threads = (struct mt_pool_thread *)calloc(workers, sizeof(struct mt_pool_thread));
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        pool->threads[i].pool = pool;
+        pool->threads[i].index = i;
+        pthread_create(&pool->threads[i].thread, NULL, mt_pool_entry, &pool->threads[i]);
+    }
+    return pool;
+}
+
+void mt_pool_delete(struct mt_pool *pool)
 {
-    struct mt_data *data = (struct mt_data *)arg;
-    struct mt_shared *shared = data->shared;
-    const struct mt_test_ops *ops = shared->ops;
+    pthread_mutex_lock(&pool->mutex);
+    pool->exit_flag = 1;
+    pthread_cond_broadcast(&pool->cond_job);
+    pthread_mutex_unlock(&pool->mutex);
 
-    // prepare
-    if (ops->prepare)
+    for (unsigned int i = 0; i < pool->workers; i++)
     {
-        ops->prepare(data);
+        pthread_join(pool->threads[i].thread, NULL);
     }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond_job);
+    pthread_cond_destroy(&pool->cond_done);
+    free(pool->threads);
+    free(pool);
+}
 
-    // warmup
-    if (ops->warmup)
-    {
-        ops->warmup(data);
-    }
+unsigned int mt_pool_workers(const struct mt_pool *pool)
+{
+    return pool->workers;
+}
 
-    // notify main thread that worker thread is ready
-    pthread_mutex_lock(&shared->mutex);
-    shared->worker_count += 1;
-    if (shared->worker_count == shared->workers)
+static void mt_pool_dispatch(struct mt_pool *pool, struct mt_data *data_list, unsigned int tasks)
+{
+    if (tasks > pool->workers)
     {
-        pthread_cond_signal(&shared->cond_w2m);
+        fprintf(stderr, "tasks %u exceeds pool workers %u\n", tasks, pool->workers);
+        abort();
     }
-    pthread_mutex_unlock(&shared->mutex);
-
-    // wait for start
-    pthread_mutex_lock(&shared->mutex);
-    while (!shared->start_fence)
+    for (unsigned int i = 0; i < tasks; i++)
     {
-        pthread_cond_wait(&shared->cond_m2w, &shared->mutex);
+        data_list[i].thread = pool->threads[i].thread;
     }
-    pthread_mutex_unlock(&shared->mutex);
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = data_list;
+    pool->job_tasks = tasks;
+    pool->done = 0;
+    pool->generation += 1;
+    pthread_cond_broadcast(&pool->cond_job);
+    pthread_mutex_unlock(&pool->mutex);
+}
 
-    // run test until stop_flag is set
-    while (!shared->stop_flag)
+static void mt_pool_wait(struct mt_pool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->done != pool->job_tasks)
     {
-        ops->test(data);
+        pthread_cond_wait(&pool->cond_done, &pool->mutex);
     }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+}
 
-    // notify main thread that worker thread is stopped
-    pthread_mutex_lock(&shared->mutex);
-    shared->worker_count -= 1;
-    if (shared->worker_count == 0)
+// cpus the first tasks workers may run on
+static void mt_worker_cpus(unsigned int tasks, cpu_set_t *cpus)
+{
+    if (!mt_places)
     {
-        pthread_cond_signal(&shared->cond_w2m);
+        if (sched_getaffinity(0, sizeof(cpu_set_t), cpus) != 0)
+        {
+            perror("sched_getaffinity");
+            abort();
+        }
+        return;
     }
-    pthread_mutex_unlock(&shared->mutex);
-
-    if (ops->clean)
+    CPU_ZERO(cpus);
+    for (unsigned int i = 0; i < tasks && i < mt_place_count; i++)
     {
-        ops->clean(data);
+        CPU_OR(cpus, cpus, &mt_places[i].cpus);
     }
-    return NULL;
-
 }
 
-double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int duration)
+static double mt_run_workers(struct mt_data *data_list, unsigned int tasks, unsigned int duration)
 {
     struct mt_shared *shared = NULL;
+    struct mt_telemetry *telemetry = NULL;
+    uint64_t first_start = UINT64_MAX, last_start = 0;
+    uint64_t first_stop = UINT64_MAX, last_stop = 0;
+    double rate = 0;
+    struct mt_result *result;
     struct timespec start_time, end_time;
     uint64_t elapsed;
     uint64_t counter = 0;
+    uint64_t *baseline;
 
     if (!tasks)
     {
         fprintf(stderr, "tasks cannot be 0\n");
         abort();
     }
+    mt_alloc_take_effective();
 
     for (unsigned int i = 0; i < tasks; i++)
     {
@@ -96,26 +1534,39 @@ double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int du
         if (i == 0)
         {
             shared = data->shared;
-            if (shared->ops == NULL)
-            {
-                fprintf(stderr, "shared->ops is not set\n");
-                abort();
-            }
-            if (shared->ops->test == NULL)
-            {
-                fprintf(stderr, "shared->ops->test is not set\n");
-                abort();
-            }
             shared->workers = tasks;
         }
-        else if (shared != data->shared)
+        else if (shared != data->shared && shared != data->shared->leader)
         {
             fprintf(stderr, "shared data is not the same\n");
             abort();
         }
+        if (data->shared->ops == NULL)
+        {
+            fprintf(stderr, "shared->ops is not set\n");
+            abort();
+        }
+        if (data->shared->ops->test == NULL)
+        {
+            fprintf(stderr, "shared->ops->test is not set\n");
+            abort();
+        }
 
         data->index = i;
-        pthread_create(&data->thread, NULL, mt_worker_entry, data);
+        if (!shared->pool)
+        {
+            pthread_create(&data->thread, NULL, mt_worker_entry, data);
+        }
+    }
+    if (shared->pool)
+    {
+        mt_pool_dispatch(shared->pool, data_list, tasks);
+    }
+
+    result = shared->result;
+    if (result)
+    {
+        memset(result, 0, sizeof(struct mt_result));
     }
 
     // wait worker_count becomes test_threads
@@ -126,20 +1577,56 @@ double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int du
     }
     pthread_mutex_unlock(&shared->mutex);
 
+    // every prepare is done, collect the page policies test memory got
+    if (result)
+    {
+        result->alloc_effective = mt_alloc_take_effective();
+    }
+
+    // counters already include the calls made by ops->warmup
+    baseline = (uint64_t *)malloc(sizeof(uint64_t) * tasks);
+    mt_snapshot(data_list, tasks, baseline);
+    if (!mt_warmup_cv || shared->steal)
+    {
+        shared->measure_flag = 1;
+    }
+
     // record start time
     clock_gettime(CLOCK_MONOTONIC, &start_time);
 
     // notify all worker threads to start
     pthread_mutex_lock(&shared->mutex);
-    shared->start_fence = 1;
+    __atomic_store_n(&shared->start_fence, 1, __ATOMIC_RELEASE);
     pthread_cond_broadcast(&shared->cond_m2w);
     pthread_mutex_unlock(&shared->mutex);
 
-    // run test for duration seconds
-    sleep(duration);
+    if (!shared->steal && mt_warmup_cv)
+    {
+        mt_steady_warmup(data_list, tasks, &start_time, baseline, result);
+        shared->measure_flag = 1;
+    }
+    if (mt_telemetry)
+    {
+        cpu_set_t cpus;
+        mt_worker_cpus(tasks, &cpus);
+        telemetry = mt_telemetry_start(&cpus);
+    }
+
+    if (!shared->steal)
+    {
+        // run test for duration seconds
+        if (result && mt_sample_interval_ms)
+        {
+            mt_sample(data_list, tasks, duration, &start_time, baseline, result);
+        }
+        else
+        {
+            sleep(duration);
+        }
 
-    // notify all worker threads to stop
-    shared->stop_flag = 1;
+        // notify all worker threads to stop
+        shared->stop_flag = 1;
+    }
 
     // wait worker_count becomes 0
     pthread_mutex_lock(&shared->mutex);
@@ -151,19 +1638,166 @@ double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int du
 
     // record end time
     clock_gettime(CLOCK_MONOTONIC, &end_time);
+    if (result)
+    {
+        result->telemetry = mt_telemetry_stop(telemetry);
+    }
+    else
+    {
+        mt_telemetry_result_free(mt_telemetry_stop(telemetry));
+    }
 
     // join all worker threads
     for (unsigned int i = 0; i < tasks; i++)
     {
-        counter += data_list[i].counter;
-        pthread_join(data_list[i].thread, NULL);
+        uint64_t worker_counter = data_list[i].counter - data_list[i].start_counter;
+        uint64_t active = data_list[i].stop_ns - data_list[i].start_ns;
+
+        counter += worker_counter;
+        if (active)
+        {
+            rate += (double) worker_counter / (active / 1000000000.0);
+        }
+        first_start = data_list[i].start_ns < first_start ? data_list[i].start_ns : first_start;
+        last_start = data_list[i].start_ns > last_start ? data_list[i].start_ns : last_start;
+        first_stop = data_list[i].stop_ns < first_stop ? data_list[i].stop_ns : first_stop;
+        last_stop = data_list[i].stop_ns > last_stop ? data_list[i].stop_ns : last_stop;
+        if (!shared->pool)
+        {
+            pthread_join(data_list[i].thread, NULL);
+        }
+    }
+    if (shared->pool)
+    {
+        mt_pool_wait(shared->pool);
+    }
+
+    elapsed = timespec_diff_ns(&start_time, &end_time);
+    // fixed-work mode measures the time to finish all items
+    if (shared->steal)
+    {
+        rate = (double) counter / (elapsed / 1000000000.0);
+    }
+    if (result)
+    {
+        result->workers = tasks;
+        result->duration = shared->steal ? 0 : duration;
+        result->elapsed_ns = elapsed;
+        result->counter = counter;
+        result->rate = rate;
+        result->unit = shared->ops->unit ? shared->ops->unit : "op";
+        result->worker_counter = (uint64_t *)malloc(sizeof(uint64_t) * tasks);
+        result->worker_active_ns = (uint64_t *)malloc(sizeof(uint64_t) * tasks);
+        for (unsigned int i = 0; i < tasks; i++)
+        {
+            result->worker_counter[i] = data_list[i].counter - data_list[i].start_counter;
+            result->worker_active_ns[i] = data_list[i].stop_ns - data_list[i].start_ns;
+        }
+        result->start_skew_ns = last_start - first_start;
+        result->stop_skew_ns = last_stop - first_stop;
+        result->overlap_ns = first_stop > last_start ? first_stop - last_start : 0;
+        if (shared->steal)
+        {
+            uint64_t start_ns = start_time.tv_sec * 1000000000ull + start_time.tv_nsec;
+            result->fixed_items = mt_fixed_items;
+            result->worker_finish_ns = (uint64_t *)malloc(sizeof(uint64_t) * tasks);
+            for (unsigned int i = 0; i < tasks; i++)
+            {
+                result->worker_finish_ns[i] = data_list[i].stop_ns - start_ns;
+            }
+        }
+    }
+    if (mt_record_latency || mt_open_rate)
+    {
+        for (unsigned int i = 0; i < tasks; i++)
+        {
+            if (result)
+            {
+                if (!result->latency)
+                {
+                    result->latency = mt_histogram_new();
+                }
+                mt_histogram_merge(result->latency, data_list[i].latency);
+            }
+            mt_histogram_delete(data_list[i].latency);
+            data_list[i].latency = NULL;
+        }
+    }
+    if (mt_perf_events)
+    {
+        for (unsigned int i = 0; i < tasks; i++)
+        {
+            if (result && data_list[i].perf)
+            {
+                if (!result->perf)
+                {
+                    result->perf = (struct mt_perf_counts *)calloc(1, sizeof(struct mt_perf_counts));
+                }
+                mt_perf_merge(result->perf, &data_list[i].perf->counts);
+            }
+            mt_perf_close(data_list[i].perf);
+            data_list[i].perf = NULL;
+        }
+        if (result && !result->perf)
+        {
+            result->perf = (struct mt_perf_counts *)calloc(1, sizeof(struct mt_perf_counts));
+        }
+    }
+    free(baseline);
+    return rate;
+}
+
+// fixed-work mode: run the items with 1 worker, then with all workers
+static double mt_run_fixed(struct mt_data *data_list, unsigned int tasks)
+{
+    struct mt_shared *shared = data_list[0].shared;
+    struct mt_result *result = shared->result;
+    struct mt_result serial;
+    struct mt_steal steal;
+    uint64_t serial_ns = 0;
+    double r;
+
+    shared->steal = &steal;
+    if (tasks > 1)
+    {
+        mt_steal_init(&steal, mt_fixed_items, 1, mt_fixed_chunk);
+        shared->result = &serial;
+        shared->serial_flag = 1;
+        mt_run_workers(data_list, 1, 0);
+        shared->serial_flag = 0;
+        serial_ns = serial.elapsed_ns;
+        mt_result_free(&serial);
+        mt_steal_destroy(&steal);
+
+        // reset the state the serial run left behind
+        shared->result = result;
+        shared->worker_count = 0;
+        shared->start_fence = 0;
+        shared->measure_flag = 0;
+        data_list[0].counter = 0;
+    }
+
+    mt_steal_init(&steal, mt_fixed_items, tasks, mt_fixed_chunk);
+    r = mt_run_workers(data_list, tasks, 0);
+    mt_steal_destroy(&steal);
+    shared->steal = NULL;
+    if (result)
+    {
+        result->serial_ns = tasks > 1 ? serial_ns : result->elapsed_ns;
     }
+    return r;
+}
 
-    elapsed = (end_time.tv_sec - start_time.tv_sec) * 1000000000 + (end_time.tv_nsec - start_time.tv_nsec);
-    return (double) counter / (elapsed / 1000000000.0);
+double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int duration)
+{
+    if (mt_fixed_items && tasks)
+    {
+        return mt_run_fixed(data_list, tasks);
+    }
+    return mt_run_workers(data_list, tasks, duration);
 }
 
-double mt_run_all_simple(const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count)
+static double mt_run_simple(struct mt_pool *pool, const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count, struct mt_result *result)
 {
     struct mt_shared shared;
     double r;
@@ -180,47 +1814,315 @@ double mt_run_all_simple(const struct mt_test_ops *ops, unsigned int tasks, unsi
     }
 
     shared.ops = ops;
+    shared.result = result;
+    shared.pool = pool;
 
-    struct mt_data *data_list = (struct mt_data *)malloc(sizeof(struct mt_data) * tasks);
-    memset(data_list, 0, sizeof(struct mt_data) * tasks);
-
-    for (size_t i = 0; i < tasks; i++)
-    {
-        data_list[i].shared = &shared;
-    }
+    struct mt_data *data_list = mt_data_new(&shared, tasks);
 
     r = mt_run_all(data_list, tasks, duration);
 
     mt_shared_destroy(&shared);
-    free(data_list);
+    mt_data_delete(data_list);
     return r;
 }
 
+double mt_run_all_simple(const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count, struct mt_result *result)
+{
+    return mt_run_simple(NULL, ops, tasks, duration, userdata, userdata_count, result);
+}
 
-#ifdef HAVE_NUMA
-#include <numa.h>
-#endif
+double mt_pool_run(struct mt_pool *pool, const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count, struct mt_result *result)
+{
+    return mt_run_simple(pool, ops, tasks, duration, userdata, userdata_count, result);
+}
 
-void *mt_alloc(size_t size)
+unsigned int mt_parse_mix(const char *arg, unsigned int tasks, mt_group_lookup lookup, struct mt_group **groups)
 {
-#ifdef HAVE_NUMA
-    if (numa_available() >= 0)
+    struct mt_group *list = (struct mt_group *)calloc(MT_MIX_MAX_GROUPS, sizeof(struct mt_group));
+    const char *p = arg;
+    unsigned int count = 0;
+    unsigned int assigned = 0;
+    unsigned int unassigned = 0;
+
+    while (1)
+    {
+        const char *end = strchr(p, '+');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        struct mt_group *group = &list[count];
+        char *colon;
+
+        if (count == MT_MIX_MAX_GROUPS)
+        {
+            fprintf(stderr, "Too many groups in mixed case: %s\n", arg);
+            goto fail;
+        }
+        group->name = strndup(p, len);
+        count++;
+        colon = strchr(group->name, ':');
+        if (colon)
+        {
+            char *num_end;
+            *colon = '\0';
+            group->workers = strtoul(colon + 1, &num_end, 10);
+            if (*num_end || group->workers == 0)
+            {
+                fprintf(stderr, "Invalid worker count in mixed case: %s\n", arg);
+                goto fail;
+            }
+            assigned += group->workers;
+        }
+        else
+        {
+            unassigned++;
+        }
+        group->scale = 1.0;
+        if (lookup(group->name, group) != 0)
+        {
+            fprintf(stderr, "Unknown test case: %s\n", group->name);
+            goto fail;
+        }
+        if (!end)
+        {
+            break;
+        }
+        p = end + 1;
+    }
+
+    if (assigned > tasks || (unassigned && tasks - assigned < unassigned))
     {
-        return numa_alloc_local(size);
+        fprintf(stderr, "Mixed case %s needs more than %u workers\n", arg, tasks);
+        goto fail;
     }
-#endif
-    return malloc(size);
+    // groups without a worker count share the rest, the first of them take the remainder
+    if (unassigned)
+    {
+        unsigned int rest = tasks - assigned;
+        unsigned int share = 0;
+        for (unsigned int g = 0; g < count; g++)
+        {
+            if (!list[g].workers)
+            {
+                list[g].workers = rest / unassigned + (share++ < rest % unassigned ? 1 : 0);
+            }
+        }
+    }
+    *groups = list;
+    return count;
+
+fail:
+    mt_mix_free(list, count);
+    return 0;
 }
 
-void mt_free(void *ptr, size_t size)
+void mt_mix_free(struct mt_group *groups, unsigned int count)
 {
-#ifdef HAVE_NUMA
-    if (numa_available() >= 0)
+    for (unsigned int g = 0; g < count; g++)
     {
-        numa_free(ptr, size);
-        return;
+        free(groups[g].name);
     }
-#endif
-    (void)size;
-    free(ptr);
+    free(groups);
+}
+
+// workers of groups left out of a mixed run sleep, so that they keep their cpus without load
+static void mt_idle_test(struct mt_data *data)
+{
+    const struct timespec pause = { 0, 1000000 };
+
+    (void)data;
+    nanosleep(&pause, NULL);
+}
+
+static const struct mt_test_ops mt_idle_ops = {
+    .test = mt_idle_test,
+};
+
+// run the groups in mask together, rates[g] gets the rate of group g in the printed unit
+static void mt_run_groups(struct mt_pool *pool, const struct mt_group *groups, unsigned int count,
+                          unsigned int mask, unsigned int duration, double *rates)
+{
+    struct mt_shared *shared = (struct mt_shared *)calloc(count, sizeof(struct mt_shared));
+    struct mt_data *data_list;
+    struct mt_result result;
+    unsigned int tasks = 0;
+    unsigned int first = 0;
+
+    for (unsigned int g = 0; g < count; g++)
+    {
+        mt_shared_init(&shared[g]);
+        shared[g].leader = g ? &shared[0] : NULL;
+        if (mask & (1u << g))
+        {
+            shared[g].ops = groups[g].ops;
+            memcpy(shared[g].userdata, groups[g].userdata, sizeof(uintptr_t) * groups[g].userdata_count);
+        }
+        else
+        {
+            shared[g].ops = &mt_idle_ops;
+        }
+        tasks += groups[g].workers;
+    }
+    shared[0].pool = pool;
+    shared[0].result = &result;
+
+    data_list = mt_data_new(&shared[0], tasks);
+    for (unsigned int g = 0; g < count; g++)
+    {
+        for (unsigned int i = 0; i < groups[g].workers; i++)
+        {
+            data_list[first + i].shared = &shared[g];
+        }
+        first += groups[g].workers;
+    }
+
+    mt_run_workers(data_list, tasks, duration);
+
+    first = 0;
+    for (unsigned int g = 0; g < count; g++)
+    {
+        double rate = 0;
+        for (unsigned int i = 0; i < groups[g].workers; i++)
+        {
+            if (result.worker_active_ns[first + i])
+            {
+                rate += result.worker_counter[first + i] / (result.worker_active_ns[first + i] / 1000000000.0);
+            }
+        }
+        first += groups[g].workers;
+        rates[g] = mask & (1u << g) ? rate * groups[g].scale : 0;
+    }
+
+    mt_result_free(&result);
+    mt_data_delete(data_list);
+    for (unsigned int g = 0; g < count; g++)
+    {
+        mt_shared_destroy(&shared[g]);
+    }
+    free(shared);
+}
+
+// repeat a mixed run -r times, rates[g] gets the median rate of group g
+static void mt_run_groups_median(struct mt_pool *pool, const struct mt_group *groups, unsigned int count,
+                                 unsigned int mask, unsigned int duration, double *rates)
+{
+    double *samples = (double *)malloc(sizeof(double) * mt_runs * count);
+    double *values = (double *)malloc(sizeof(double) * mt_runs);
+    struct mt_stats stats;
+
+    for (unsigned int i = 0; i < mt_runs; i++)
+    {
+        if (i && mt_cooldown)
+        {
+            sleep(mt_cooldown);
+        }
+        mt_run_groups(pool, groups, count, mask, duration, &samples[i * count]);
+    }
+    for (unsigned int g = 0; g < count; g++)
+    {
+        for (unsigned int i = 0; i < mt_runs; i++)
+        {
+            values[i] = samples[i * count + g];
+        }
+        mt_stats_compute(values, mt_runs, &stats);
+        rates[g] = stats.median;
+    }
+    free(values);
+    free(samples);
+}
+
+void mt_run_together(struct mt_pool *pool, const struct mt_group *groups, unsigned int count, unsigned int duration, double *rates)
+{
+    if (mt_fixed_items)
+    {
+        fprintf(stderr, "Groups cannot run together with fixed work\n");
+        exit(EXIT_FAILURE);
+    }
+    // calibrate before workers read it
+    mt_ticks_per_ns();
+    mt_run_groups_median(pool, groups, count, (1u << count) - 1, duration, rates);
+}
+
+static double mt_slowdown(double alone, double mixed)
+{
+    return mixed > 0 ? alone / mixed : 0;
+}
+
+void mt_run_mix(const char *name, struct mt_pool *pool, const struct mt_group *groups, unsigned int count, unsigned int duration)
+{
+    double *alone = (double *)malloc(sizeof(double) * count);
+    double *mixed = (double *)malloc(sizeof(double) * count);
+    double *pair = (double *)calloc(count * count, sizeof(double));
+    double *rates = (double *)malloc(sizeof(double) * count);
+
+    if (mt_fixed_items)
+    {
+        fprintf(stderr, "Mixed case %s cannot run with fixed work\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned int g = 0; g < count; g++)
+    {
+        mt_run_groups_median(pool, groups, count, 1u << g, duration, rates);
+        alone[g] = rates[g];
+    }
+    // pair[victim * count + aggressor]: rate of victim next to aggressor only
+    for (unsigned int v = 0; count > 2 && v < count; v++)
+    {
+        for (unsigned int a = v + 1; a < count; a++)
+        {
+            mt_run_groups_median(pool, groups, count, (1u << v) | (1u << a), duration, rates);
+            pair[v * count + a] = rates[v];
+            pair[a * count + v] = rates[a];
+        }
+    }
+    mt_run_groups_median(pool, groups, count, (1u << count) - 1, duration, mixed);
+
+    if (mt_output == MT_OUTPUT_JSON)
+    {
+        mt_output_mix_json(stdout, name, groups, count, alone, mixed, count > 2 ? pair : NULL);
+    }
+    else if (mt_output == MT_OUTPUT_CSV)
+    {
+        mt_output_mix_csv(stdout, groups, count, duration, alone, mixed, count > 2 ? pair : NULL);
+    }
+    else
+    {
+        printf("%s\n", name);
+        printf("  %-18s%-9s%-14s%-14s%s\n", "group", "workers", "alone", "mixed", "slowdown");
+        for (unsigned int g = 0; g < count; g++)
+        {
+            printf("  %-18s%-9u%-14.2f%-14.2f%.2fx\n", groups[g].name, groups[g].workers,
+                   alone[g], mixed[g], mt_slowdown(alone[g], mixed[g]));
+        }
+        if (count > 2)
+        {
+            // slowdown of the row group when it runs next to the column group only
+            printf("  %-18s", "next to");
+            for (unsigned int a = 0; a < count; a++)
+            {
+                printf("%-12s", groups[a].name);
+            }
+            printf("\n");
+            for (unsigned int v = 0; v < count; v++)
+            {
+                printf("  %-18s", groups[v].name);
+                for (unsigned int a = 0; a < count; a++)
+                {
+                    if (a == v)
+                    {
+                        printf("%-12s", "-");
+                    }
+                    else
+                    {
+                        printf("%-12.2f", mt_slowdown(alone[v], pair[v * count + a]));
+                    }
+                }
+                printf("\n");
+            }
+        }
+    }
+
+    free(alone);
+    free(mixed);
+    free(pair);
+    free(rates);
 }
@@ -1,10 +1,20 @@
 #ifndef __multitask_h__
 #define __multitask_h__
 
+#include <stdio.h>
 #include <stdint.h>
 #include <pthread.h>
 
+// workers never share a cache line, 128 also covers adjacent line prefetch
+#define MT_CACHELINE_SIZE 128
+
 struct mt_data;
+struct mt_histogram;
+struct mt_steal;
+struct mt_perf;
+struct mt_perf_counts;
+struct mt_telemetry_result;
+struct mt_pool;
 typedef void (*mt_func)(struct mt_data*);
 
 struct mt_test_ops
@@ -13,12 +23,61 @@ struct mt_test_ops
     mt_func clean;
     mt_func warmup;
     mt_func test;
+    const char *unit;                       // what one counter step counts, like "byte", NULL: "op"
+};
+
+struct mt_result
+{
+    unsigned int workers;
+    unsigned int duration;                  // requested seconds, 0 in fixed-work mode
+    uint64_t elapsed_ns;
+    uint64_t counter;                       // sum of all worker counters
+    double rate;                            // sum of worker rates, counter per second over elapsed_ns in fixed-work mode
+    const char *unit;                       // counter unit of the case, see mt_test_ops
+    uint64_t *worker_counter;               // counter of every worker
+    uint64_t *worker_active_ns;             // measured window of every worker, from its first call to its last return
+    uint64_t start_skew_ns;                 // last worker start - first worker start
+    uint64_t stop_skew_ns;                  // last worker stop - first worker stop
+    uint64_t overlap_ns;                    // window all workers were measuring, 0 if they never overlapped
+
+    // time series, only filled when sampling is enabled
+    unsigned int intervals;
+    uint64_t *interval_ns;                  // length of every interval
+    uint64_t *interval_counter;             // counter increment of [interval * workers + worker]
+
+    // adaptive warm-up before the measured window, only filled when it is enabled
+    uint64_t warmup_ns;
+    unsigned int warmup_steady;             // coefficient of variation dropped below the threshold
+    double warmup_cv;                       // coefficient of variation of the last windows in percent
+
+    // fixed-work mode, only filled when it is enabled
+    uint64_t fixed_items;                   // 0: throughput mode
+    uint64_t serial_ns;                     // time the same work takes with 1 worker
+    uint64_t *worker_finish_ns;             // time every worker ran out of work
+
+    // bitmask of page policies (1 << MT_ALLOC_*) that test memory got in prepare
+    unsigned int alloc_effective;
+
+    // perf event counts of all workers in the measured window, only filled when enabled
+    struct mt_perf_counts *perf;
+
+    // frequency, temperature and energy of the measured window, only filled when enabled and available
+    struct mt_telemetry_result *telemetry;
+
+    // merged latency of every ops->test call in ticks, only filled when latency recording is enabled
+    struct mt_histogram *latency;
 };
 
 struct mt_shared
 {
     const struct mt_test_ops *ops;
+    struct mt_result *result;               // optional, filled by mt_run_all
+    struct mt_steal *steal;                 // fixed-work mode: workers run until all items are done
+    struct mt_pool *pool;                   // optional, run on pool threads instead of new threads
+    struct mt_shared *leader;               // mixed mode: shared of the first group, it synchronizes all groups
     volatile unsigned int stop_flag;        // when set, worker thread should stop
+    volatile unsigned int measure_flag;     // set when warm-up is over and the measured window begins
+    unsigned int serial_flag;               // fixed-work mode: set during the 1-worker reference run
     pthread_mutex_t mutex;                  // protect worker_count and cond_m2w, cond_w2m
     pthread_cond_t cond_m2w;                // main thread to worker thread
     pthread_cond_t cond_w2m;                // worker thread to main thread
@@ -35,32 +94,173 @@ struct mt_data
     unsigned int index;
     pthread_t thread;
     struct mt_shared *shared;
-    uint64_t counter;
+    uint64_t counter;                       // written by the worker, read by the sampler
+    struct mt_histogram *latency;           // per worker, so recording needs no lock
+    struct mt_perf *perf;                   // per worker perf event group
+    uint64_t start_counter;                 // counter when the worker began its measured window
+    uint64_t start_ns;                      // monotonic time of the first measured call
+    uint64_t stop_ns;                       // monotonic time the last measured call returned
 
     // tester use:
     uintptr_t userdata[8];
-};
+} __attribute__((aligned(MT_CACHELINE_SIZE)));
 
 
 void mt_shared_init(struct mt_shared *shared);
 void mt_shared_destroy(struct mt_shared *shared);
 
+// allocate cache line aligned, zeroed worker data bound to shared
+struct mt_data *mt_data_new(struct mt_shared *shared, unsigned int tasks);
+void mt_data_delete(struct mt_data *data_list);
+
+void mt_result_free(struct mt_result *result);
+// print per worker and per interval rates when sampling is enabled and latency percentiles
+// when latency recording is enabled, rates are multiplied by scale
+void mt_result_print(FILE *f, const struct mt_result *result, double scale);
+
 // return rate in counter per second
+// with -s the workers share a fixed number of ops->test calls instead of running for duration,
+// and the same work is run with 1 worker first to report speedup
 double mt_run_all(struct mt_data *data_list, unsigned int tasks, unsigned int duration);
-double mt_run_all_simple(const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count);
+// result is optional and must be released by mt_result_free
+double mt_run_all_simple(const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count, struct mt_result *result);
+
+// spin wait hint
+static inline void mt_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
 
+// only the owner thread writes counter, relaxed store keeps the sampler read race free
 static inline void mt_counter_inc(struct mt_data *data)
 {
-    data->counter++;
+    __atomic_store_n(&data->counter, data->counter + 1, __ATOMIC_RELAXED);
 }
 
 static inline void mt_counter_add(struct mt_data *data, unsigned int value)
 {
-    data->counter += value;
+    __atomic_store_n(&data->counter, data->counter + value, __ATOMIC_RELAXED);
 }
 
-// support numa allocate
+// options shared by all xb-* tools, append MT_OPTSTRING to the getopt string
+#define MT_OPTSTRING "p:i:lr:c:w:W:s:m:efo:R:A:b"
+
+// return 1 if opt is a shared option and has been handled
+int mt_parse_opt(int opt, const char *arg);
+void mt_usage_opts(FILE *f);
+// -o text is the default, tools print their headers only in text output
+int mt_output_text(void);
+// -r, the runs of every case
+unsigned int mt_run_count(void);
+// -p is given, workers are pinned by placement
+int mt_placed(void);
+
+// persistent workers: threads are created and pinned once, then run one case after another
+// with the same semantics as mt_run_all_simple, set mt_shared.pool to use them from mt_run_all
+struct mt_pool *mt_pool_new(unsigned int workers);
+void mt_pool_delete(struct mt_pool *pool);
+unsigned int mt_pool_workers(const struct mt_pool *pool);
+// the first tasks pool threads take part, tasks must not exceed the pool workers
+double mt_pool_run(struct mt_pool *pool, const struct mt_test_ops *ops, unsigned int tasks, unsigned int duration, const uintptr_t *userdata, uintptr_t userdata_count, struct mt_result *result);
+
+// run a test case once with tasks workers, return the rate in the printed unit,
+// fill result with counter based rates
+typedef double (*mt_case_func)(const void *arg, unsigned int tasks, struct mt_result *result);
+
+// parse the -T argument: thread counts like "4", "1,2,4", "1-4" (every count) or "8..N" (doubling,
+// N is the number of usable cpus), return the largest count
+unsigned int mt_parse_threads(const char *arg);
+
+// run a test case -r times and print its result line, the printed rate is the median of all runs,
+// scale converts result counter rates to the printed unit
+// with -o json or -o csv the case is printed as one JSON line or as CSV rows instead
+// with a -T list the case runs once per thread count and a scaling summary follows
+void mt_run_case(const char *name, mt_case_func run, const void *arg, double scale);
+// same as mt_run_case, median gets the median rate of every thread count in -T order
+void mt_run_case_rates(const char *name, mt_case_func run, const void *arg, double scale, double *median);
+// run a test case -r times with tasks workers regardless of -T, print it like one thread count
+// of mt_run_case without a scaling summary and return the median rate
+double mt_run_case_at(const char *name, mt_case_func run, const void *arg, double scale, unsigned int tasks);
+// thread counts of -T in the order they run, return the count
+unsigned int mt_thread_counts(const unsigned int **list);
+// print the working set sweep of one case, rates[size * thread count + thread] in the
+// printed unit, as a size by thread count table or one JSON line
+void mt_report_sizes(const char *name, const char *unit, const size_t *sizes, unsigned int count, const double *rates);
+// print a matrix of one case, values[row * col_count + col] in unit,
+// as a table under title or one JSON line with title as "matrix"
+void mt_report_matrix(const char *name, const char *title, const char *unit, const char *const *rows,
+                      unsigned int row_count, const char *const *cols, unsigned int col_count, const double *values);
+// as mt_report_matrix for cases measured outside mt_run_case, csv gets one row per cell
+void mt_report_matrix_cells(const char *name, const char *title, const char *unit, const char *const *rows,
+                            unsigned int row_count, const char *const *cols, unsigned int col_count,
+                            const double *values);
+// bytes as 64K, 8M or 2G, the largest unit that divides size
+void mt_format_size(char *buf, size_t len, size_t size);
+
+// mixed mode: groups of workers run different cases at the same time,
+// workers of a group follow the workers of the previous group in placement order
+#define MT_MIX_MAX_GROUPS 16
+
+struct mt_group
+{
+    char *name;
+    const struct mt_test_ops *ops;
+    uintptr_t userdata[8];                  // copied to mt_shared.userdata of the group
+    uintptr_t userdata_count;
+    unsigned int workers;
+    double scale;                           // converts counter per second to the printed unit
+};
+
+// fill ops, userdata and scale of case name, return 0 if name is known
+typedef int (*mt_group_lookup)(const char *name, struct mt_group *group);
+
+// parse "A[:workers]+B[:workers]...", groups without a worker count share the rest of tasks evenly
+// return group count, 0 on error, groups must be released by mt_mix_free
+unsigned int mt_parse_mix(const char *arg, unsigned int tasks, mt_group_lookup lookup, struct mt_group **groups);
+void mt_mix_free(struct mt_group *groups, unsigned int count);
+// run every group alone, every pair of groups when there are more than 2 and all groups together,
+// workers of groups left out idle on their cpus, print the rate of every group and its slowdown
+void mt_run_mix(const char *name, struct mt_pool *pool, const struct mt_group *groups, unsigned int count, unsigned int duration);
+// run all groups together -r times, rates[g] gets the median rate of group g in its printed unit
+void mt_run_together(struct mt_pool *pool, const struct mt_group *groups, unsigned int count, unsigned int duration, double *rates);
+
+// pin the calling thread to the cpus (and numa node) planned for worker index
+void mt_bind_worker(unsigned int index);
+// pin the calling thread to the allowed cpus of numa node, return 0 on success,
+// mt_unbind_node restores the affinity the thread had before
+int mt_bind_node(int node);
+void mt_unbind_node(void);
+
+// page policy of mt_alloc, selected with -m
+enum
+{
+    MT_ALLOC_DEFAULT,                       // numa local allocation, page size left to the kernel
+    MT_ALLOC_4K,                            // MADV_NOHUGEPAGE
+    MT_ALLOC_THP,                           // MADV_HUGEPAGE
+    MT_ALLOC_2M,                            // MAP_HUGETLB, falls back to thp
+    MT_ALLOC_1G,                            // MAP_HUGETLB, falls back to thp
+    MT_ALLOC_INTERLEAVE,                    // numa interleave over all nodes
+    MT_ALLOC_POLICY_COUNT,
+};
+
+int mt_alloc_set_policy(const char *name);
+unsigned int mt_alloc_get_policy(void);
+const char *mt_alloc_policy_name(unsigned int policy);
+// return the bitmask of policies that took effect since the last call, call it after the
+// memory is touched, thp is checked against the huge pages that back it
+unsigned int mt_alloc_take_effective(void);
+
+// support numa allocate, size passed to mt_free must match mt_alloc
 void *mt_alloc(size_t size);
 void mt_free(void *ptr, size_t size);
+// memory bound to numa node, node -1 interleaves over all nodes, NULL without libnuma
+void *mt_alloc_onnode(size_t size, int node);
+void mt_free_onnode(void *ptr, size_t size);
+// numa nodes that have cpus (with_cpus) or memory (!with_cpus), return the count, 0 without libnuma
+unsigned int mt_numa_nodes(int *nodes, unsigned int max, int with_cpus);
 
 #endif
@@ -5,8 +5,9 @@
 #include <string.h>
 #include <math.h>
 #include <getopt.h>
-#include "cputest-algorithm.h"
-#include "cputest-mat.h"
+#include <pthread.h>
+#include "cputest-cases.h"
+#include "cputest-sync.h"
 #include "multitask.h"
 
 #ifndef TEST_DURATION
@@ -16,9 +17,11 @@
 static unsigned int test_quiet;
 static unsigned int test_duration;
 static unsigned int test_threads;
+static unsigned int test_cs_length;
 
 static size_t test_case_count;
 static char **test_case_list;
+static struct mt_pool *test_pool;
 
 static void usage(FILE *f)
 {
@@ -27,13 +30,22 @@ static void usage(FILE *f)
                 "  -h            print this help\n"
                 "  -q            print less information\n"
                 "  -t <duration> Specify the duration to test\n"
-                "  -T <threads>  Specify the number of threads to test\n");
+                "  -T <threads>  Specify the number of threads to test, a list like 1,2,4 or 1..N\n"
+                "                runs every count and reports speedup and scaling fits\n"
+                "  -L <loops>    Specify the critical section length of the SYNC cases in idle loops\n"
+                "Cases:\n"
+                "  PRIME FIB XORSHIFT SORT-I32 SORT-U64 CIRCLE FPMAT-MUL FPMAT-CONV\n"
+                "                the default run\n"
+                "  SYNC          all workers contend on shared state, rate is operations per second:\n"
+                "                ATOMIC-ADD CAS SPINLOCK TICKET MCS MUTEX RWLOCK RWLOCK-READ\n"
+                "                run only when named, SYNC runs all of them\n");
+    mt_usage_opts(f);
 }
 
 static void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hqt:T:")) != -1)
+    while ((opt = getopt(argc, argv, "hqt:T:L:" MT_OPTSTRING)) != -1)
     {
         switch (opt)
         {
@@ -47,9 +59,16 @@ static void parse_args(int argc, char *argv[])
             test_duration = atoi(optarg);
             break;
         case 'T':
-            test_threads = atoi(optarg);
+            test_threads = mt_parse_threads(optarg);
+            break;
+        case 'L':
+            test_cs_length = atoi(optarg);
             break;
         default:
+            if (mt_parse_opt(opt, optarg))
+            {
+                break;
+            }
             usage(stderr);
             exit(EXIT_FAILURE);
         }
@@ -68,327 +87,245 @@ static void parse_args(int argc, char *argv[])
     test_case_list = argv + optind;
 }
 
-static void prime_task(struct mt_data *data)
+// SYNC cases: all workers operate on one shared state, an operation is one atomic update
+// or one lock acquire, critical section and release
+enum sync_kind
 {
-    if (prime_count(29000) != 3153)
-    {
-        fprintf(stderr, "prime_count(29000) != 3153\n");
-        abort();
-    }
-    mt_counter_inc(data);
-}
-
-static struct mt_test_ops prime_ops = {
-    .warmup = prime_task,
-    .test = prime_task,
+    SYNC_ATOMIC_ADD,
+    SYNC_CAS,
+    SYNC_SPINLOCK,
+    SYNC_TICKET,
+    SYNC_MCS,
+    SYNC_MUTEX,
+    SYNC_RWLOCK,
+    SYNC_RWLOCK_READ,
 };
 
-static void fib_task(struct mt_data *data)
-{
-    if (fib_value(1650000) != 17024848350435039168ull)
-    {
-        fprintf(stderr, "fib_value(1650000) != 17024848350435039168ull\n");
-        abort();
-    }
-    mt_counter_inc(data);
-}
+#define SYNC_OPS_PER_CALL 256
 
-static struct mt_test_ops fib_ops = {
-    .warmup = fib_task,
-    .test = fib_task,
+struct sync_state
+{
+    struct spin_lock spin;
+    struct ticket_lock ticket;
+    struct mcs_lock mcs;
+    pthread_mutex_t mutex __attribute__((aligned(MT_CACHELINE_SIZE)));
+    pthread_rwlock_t rwlock __attribute__((aligned(MT_CACHELINE_SIZE)));
+    uint64_t atomic __attribute__((aligned(MT_CACHELINE_SIZE)));   // updated by ATOMIC-ADD and CAS
+    uint64_t value __attribute__((aligned(MT_CACHELINE_SIZE)));    // protected by the lock under test
+    uint64_t ops __attribute__((aligned(MT_CACHELINE_SIZE)));      // operations done by all workers
 };
 
-#define XORSHIFT_SEED 8675728858075378228ull
+static struct sync_state sync_state = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .rwlock = PTHREAD_RWLOCK_INITIALIZER,
+};
 
-static void xorshift_task(struct mt_data *data)
+// the critical section, loops the compiler cannot remove
+static inline void sync_idle(unsigned int loops)
 {
-    if (xorshift_nstep(XORSHIFT_SEED, 700000) != 7971562545477045910ull)
+    for (unsigned int i = 0; i < loops; i++)
     {
-        fprintf(stderr, "xorshift_nstep(XORSHIFT_SEED, 700000) != 7971562545477045910ull\n");
-        abort();
+        __asm__ volatile("");
     }
-
-    mt_counter_inc(data);
 }
 
-static struct mt_test_ops xorshift_ops = {
-    .warmup = xorshift_task,
-    .test = xorshift_task,
-};
-
-#define CIRCLE_WIDTH  250
-#define CIRCLE_HEIGHT 180
-#define CIRCLE_RADIUS 100
-#define CIRCLE_CENTER_X (CIRCLE_WIDTH / 2)
-#define CIRCLE_CENTER_Y (CIRCLE_HEIGHT / 2)
-
-static void circle_prepare(struct mt_data *data)
+static void sync_prepare(struct mt_data *data)
 {
-    data->userdata[0] = (uintptr_t)mt_alloc(CIRCLE_WIDTH * CIRCLE_HEIGHT * sizeof(uint32_t));
+    data->userdata[0] = (uintptr_t)mt_alloc(sizeof(struct mcs_node));  // queue node of this worker
+    data->userdata[1] = 0;                                              // operations done
 }
 
-static void circle_clean(struct mt_data *data)
+static void sync_clean(struct mt_data *data)
 {
-    mt_free((void *)data->userdata[0], CIRCLE_WIDTH * CIRCLE_HEIGHT * sizeof(uint32_t));
+    mt_free((void *)data->userdata[0], sizeof(struct mcs_node));
+    __atomic_fetch_add(&sync_state.ops, data->userdata[1], __ATOMIC_RELAXED);
 }
 
-static void circle_task(struct mt_data *data)
+static void sync_task(struct mt_data *data)
 {
-    uint32_t *buffer = (uint32_t *)data->userdata[0];
-    render_circle(buffer, CIRCLE_WIDTH, CIRCLE_HEIGHT, CIRCLE_CENTER_X, CIRCLE_CENTER_Y, CIRCLE_RADIUS);
-    mt_counter_inc(data);
-}
-
-static struct mt_test_ops circle_ops = {
-    .prepare = circle_prepare,
-    .clean = circle_clean,
-    .warmup = circle_task,
-    .test = circle_task,
-};
-
-#define SORTI32_ELEMENTS (12500)
+    enum sync_kind kind = (enum sync_kind)data->shared->userdata[0];
+    struct mcs_node *node = (struct mcs_node *)data->userdata[0];
+    struct sync_state *state = &sync_state;
+    unsigned int loops = test_cs_length;
 
-static int32_t sorti32_generate(uint64_t *state)
-{
-    *state = xorshift_next(*state);
-    return (int32_t)(*state & (-1));
-}
-
-static int sorti32_compare(const void *a, const void *b)
-{
-    return *(int32_t *)a - *(int32_t *)b;
-}
-
-static void sorti32_prepare(struct mt_data *data)
-{
-    size_t element = SORTI32_ELEMENTS;
-    size_t element_x2 = element * 2;
-    data->userdata[0] = (uintptr_t)mt_alloc(element_x2 * sizeof(int32_t)); // unsorted data
-    data->userdata[1] = data->userdata[0] + element * sizeof(int32_t);     // sort buffer
-    data->userdata[2] = element;                                           // element count
-
-    int32_t *unsorted = (int32_t *)data->userdata[0];
-    uint64_t state = XORSHIFT_SEED;
-    for (size_t i = 0; i < element; i++)
+    for (unsigned int i = 0; i < SYNC_OPS_PER_CALL; i++)
     {
-        unsorted[i] = sorti32_generate(&state);
+        switch (kind)
+        {
+        case SYNC_ATOMIC_ADD:
+            // nothing to protect, the loops run before every add
+            sync_idle(loops);
+            __atomic_fetch_add(&state->atomic, 1, __ATOMIC_RELAXED);
+            break;
+        case SYNC_CAS:
+        {
+            // the loops run between load and swap, a longer window fails more swaps
+            uint64_t old = __atomic_load_n(&state->atomic, __ATOMIC_RELAXED);
+            do
+            {
+                sync_idle(loops);
+            } while (!__atomic_compare_exchange_n(&state->atomic, &old, old + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+            break;
+        }
+        case SYNC_SPINLOCK:
+            spin_lock_acquire(&state->spin);
+            state->value++;
+            sync_idle(loops);
+            spin_lock_release(&state->spin);
+            break;
+        case SYNC_TICKET:
+            ticket_lock_acquire(&state->ticket);
+            state->value++;
+            sync_idle(loops);
+            ticket_lock_release(&state->ticket);
+            break;
+        case SYNC_MCS:
+            mcs_lock_acquire(&state->mcs, node);
+            state->value++;
+            sync_idle(loops);
+            mcs_lock_release(&state->mcs, node);
+            break;
+        case SYNC_MUTEX:
+            pthread_mutex_lock(&state->mutex);
+            state->value++;
+            sync_idle(loops);
+            pthread_mutex_unlock(&state->mutex);
+            break;
+        case SYNC_RWLOCK:
+            pthread_rwlock_wrlock(&state->rwlock);
+            state->value++;
+            sync_idle(loops);
+            pthread_rwlock_unlock(&state->rwlock);
+            break;
+        case SYNC_RWLOCK_READ:
+            // readers hold the lock together, only the lock word is contended
+            pthread_rwlock_rdlock(&state->rwlock);
+            __asm__ volatile("" : : "r"(state->value));
+            sync_idle(loops);
+            pthread_rwlock_unlock(&state->rwlock);
+            break;
+        }
     }
+    data->userdata[1] += SYNC_OPS_PER_CALL;
+    mt_counter_add(data, SYNC_OPS_PER_CALL);
 }
 
-static void sorti32_clean(struct mt_data *data)
-{
-    mt_free((void *)data->userdata[0], SORTI32_ELEMENTS * 2 * sizeof(int32_t));
-}
+static struct mt_test_ops sync_ops = {
+    .prepare = sync_prepare,
+    .clean = sync_clean,
+    .warmup = sync_task,
+    .test = sync_task,
+};
 
-static void sorti32_task(struct mt_data *data)
-{
-    int32_t *unsorted = (int32_t *)data->userdata[0];
-    int32_t *buffer = (int32_t *)data->userdata[1];
-    size_t element = data->userdata[2];
-    memcpy(buffer, unsorted, element * sizeof(int32_t));
-    qsort(buffer, element, sizeof(int32_t), sorti32_compare);
-    mt_counter_inc(data);
-}
+#define SYNC_FUNCTION(case_name, kind)              \
+    {                                               \
+        .name = case_name,                          \
+        .ops = &sync_ops,                           \
+        .userdata = (const uintptr_t[]){kind},      \
+        .userdata_count = 1,                        \
+    }
 
-static struct mt_test_ops sort_i32_ops = {
-    .prepare = sorti32_prepare,
-    .clean = sorti32_clean,
-    .warmup = sorti32_task,
-    .test = sorti32_task,
+// not part of the default run, contention rates say little about a single core
+static struct cpu_case sync_functions[] = {
+    SYNC_FUNCTION("ATOMIC-ADD", SYNC_ATOMIC_ADD),
+    SYNC_FUNCTION("CAS", SYNC_CAS),
+    SYNC_FUNCTION("SPINLOCK", SYNC_SPINLOCK),
+    SYNC_FUNCTION("TICKET", SYNC_TICKET),
+    SYNC_FUNCTION("MCS", SYNC_MCS),
+    SYNC_FUNCTION("MUTEX", SYNC_MUTEX),
+    SYNC_FUNCTION("RWLOCK", SYNC_RWLOCK),
+    SYNC_FUNCTION("RWLOCK-READ", SYNC_RWLOCK_READ),
 };
 
-#define SORTU64_ELEMENTS (12500)
-static uint64_t sortu64_generate(uint64_t *state)
-{
-    *state = xorshift_next(*state);
-    return *state;
-}
-
-static int sortu64_compare(const void *a, const void *b)
+// every update of the shared state must be accounted for by exactly one operation
+static void sync_verify(const struct cpu_case *function, uint64_t atomic, uint64_t value)
 {
-    return *(uint64_t *)a - *(uint64_t *)b;
-}
+    enum sync_kind kind = (enum sync_kind)function->userdata[0];
+    uint64_t updates;
 
-static void sortu64_prepare(struct mt_data *data)
-{
-    size_t element = SORTU64_ELEMENTS;
-    size_t element_x2 = element * 2;
-    data->userdata[0] = (uintptr_t)mt_alloc(element_x2 * sizeof(uint64_t)); // unsorted data
-    data->userdata[1] = data->userdata[0] + element * sizeof(uint64_t);     // sort buffer
-    data->userdata[2] = element;                                           // element count
-
-    uint64_t *unsorted = (uint64_t *)data->userdata[0];
-    uint64_t state = XORSHIFT_SEED;
-    for (size_t i = 0; i < element; i++)
+    if (kind == SYNC_RWLOCK_READ)
     {
-        unsorted[i] = sortu64_generate(&state);
+        return;
+    }
+    updates = kind == SYNC_ATOMIC_ADD || kind == SYNC_CAS ? sync_state.atomic - atomic : sync_state.value - value;
+    if (updates != sync_state.ops)
+    {
+        fprintf(stderr, "%s: %llu updates for %llu operations\n", function->name,
+                (unsigned long long)updates, (unsigned long long)sync_state.ops);
+        abort();
     }
 }
 
-static void sortu64_clean(struct mt_data *data)
+static double run_test_once(const void *arg, unsigned int tasks, struct mt_result *result)
 {
-    mt_free((void *)data->userdata[0], SORTU64_ELEMENTS * 2 * sizeof(uint64_t));
+    const struct cpu_case *function = (const struct cpu_case *)arg;
+    uint64_t atomic = sync_state.atomic;
+    uint64_t value = sync_state.value;
+    double rate;
+
+    sync_state.ops = 0;
+    rate = mt_pool_run(test_pool, function->ops, tasks, test_duration, function->userdata, function->userdata_count, result);
+    if (function->ops == &sync_ops)
+    {
+        sync_verify(function, atomic, value);
+    }
+    return rate;
 }
 
-static void sortu64_task(struct mt_data *data)
+static void run_test_function(const struct cpu_case *function)
 {
-    uint64_t *unsorted = (uint64_t *)data->userdata[0];
-    uint64_t *buffer = (uint64_t *)data->userdata[1];
-    size_t element = data->userdata[2];
-    memcpy(buffer, unsorted, element * sizeof(uint64_t));
-    qsort(buffer, element, sizeof(uint64_t), sortu64_compare);
-    mt_counter_inc(data);
+    mt_run_case(function->name, run_test_once, function, 1.0);
 }
 
-static struct mt_test_ops sort_u64_ops = {
-    .prepare = sortu64_prepare,
-    .clean = sortu64_clean,
-    .warmup = sortu64_task,
-    .test = sortu64_task,
-};
-
-// static const uintptr_t fpmat_add_data[] = {
-//     (uintptr_t)mat_add,
-//     2000,
-//     2000,
-//     2000,
-//     2000,
-// };
-
-static const uintptr_t fpmat_mul_data[] = {
-    (uintptr_t)mat_mul,
-    125,
-    80,
-    80,
-    125,
-};
-
-static const uintptr_t fpmat_conv_data[] = {
-    (uintptr_t)mat_conv,
-    90,
-    60,
-    11,
-    13,
-};
-
-static void fpmat_prepare(struct mt_data *data)
+static const struct cpu_case *find_test_function(const char *name)
 {
-    struct mt_shared *shared = data->shared;
-    unsigned int a_row = shared->userdata[1];
-    unsigned int a_col = shared->userdata[2];
-    unsigned int b_row = shared->userdata[3];
-    unsigned int b_col = shared->userdata[4];
-
-    Mat *a = mat_new();
-    Mat *b = mat_new();
-    Mat *c = mat_new();
+    const struct cpu_case *function = cpu_case_lookup(name);
 
-    mat_set_shape(a, a_row, a_col);
-    mat_set_shape(b, b_row, b_col);
-
-    data->userdata[0] = (uintptr_t)a;
-    data->userdata[1] = (uintptr_t)b;
-    data->userdata[2] = (uintptr_t)c;
-
-    uint64_t state = XORSHIFT_SEED;
-    float *p;
-
-
-    p = a->data;
-    for (unsigned int i = 0; i < a_row * a_col; i++)
+    if (function)
     {
-        *p++ = (float)xorshift_next(state) / UINT64_MAX;
+        return function;
     }
-
-    p = b->data;
-    for (unsigned int i = 0; i < b_row * b_col; i++)
+    for (size_t j = 0; j < sizeof(sync_functions) / sizeof(sync_functions[0]); j++)
     {
-        *p++ = (float)xorshift_next(state) / UINT64_MAX;
+        if (strcasecmp(name, sync_functions[j].name) == 0)
+        {
+            return &sync_functions[j];
+        }
     }
+    return NULL;
 }
 
-static void fpmat_clean(struct mt_data *data)
+static int lookup_test_function(const char *name, struct mt_group *group)
 {
-    mat_delete((Mat *)data->userdata[0]);
-    mat_delete((Mat *)data->userdata[1]);
-    mat_delete((Mat *)data->userdata[2]);
-}
+    const struct cpu_case *function = find_test_function(name);
 
-static void fpmat_task(struct mt_data *data)
-{
-    Mat *a = (Mat *)data->userdata[0];
-    Mat *b = (Mat *)data->userdata[1];
-    Mat *c = (Mat *)data->userdata[2];
-    void (*mat_op)(const Mat *, const Mat *, Mat *) = (void (*)(const Mat *, const Mat *, Mat *))data->shared->userdata[0];
-    mat_op(a, b, c);
-    mt_counter_inc(data);
+    if (!function)
+    {
+        return -1;
+    }
+    cpu_case_group(function, group);
+    return 0;
 }
 
-static struct mt_test_ops fpmat_ops = {
-    .prepare = fpmat_prepare,
-    .clean = fpmat_clean,
-    .warmup = fpmat_task,
-    .test = fpmat_task,
-};
-
-struct test_function
+// cases joined with '+' run at the same time on separate workers
+static void run_test_mix(const char *cases)
 {
-    const char *name;
-    struct mt_test_ops *ops;
-    const uintptr_t *userdata;
-    size_t userdata_count;
-};
+    struct mt_group *groups;
+    unsigned int count = mt_parse_mix(cases, test_threads, lookup_test_function, &groups);
 
-static struct test_function test_functions[] = {
-    {
-        .name = "PRIME",
-        .ops = &prime_ops,
-    },
-    {
-        .name = "FIB",
-        .ops = &fib_ops,
-    },
-    {
-        .name = "XORSHIFT",
-        .ops = &xorshift_ops,
-    },
+    if (!count)
     {
-        .name = "SORT-I32",
-        .ops = &sort_i32_ops,
-    },
-    {
-        .name = "SORT-U64",
-        .ops = &sort_u64_ops,
-    },
-    {
-        .name = "CIRCLE",
-        .ops = &circle_ops,
-    },
-    // 这个测试意义不大，计算太简单，测试的其实主要是内存I/O
-    // {
-    //     .name = "FPMAT-ADD",
-    //     .ops = &fpmat_ops,
-    //     .userdata = fpmat_add_data,
-    //     .userdata_count = sizeof(fpmat_add_data) / sizeof(fpmat_add_data[0]),
-    // },
-    {
-        .name = "FPMAT-MUL",
-        .ops = &fpmat_ops,
-        .userdata = fpmat_mul_data,
-        .userdata_count = sizeof(fpmat_mul_data) / sizeof(fpmat_mul_data[0]),
-    },
-    {
-        .name = "FPMAT-CONV",
-        .ops = &fpmat_ops,
-        .userdata = fpmat_conv_data,
-        .userdata_count = sizeof(fpmat_conv_data) / sizeof(fpmat_conv_data[0]),
-    },
-};
+        exit(EXIT_FAILURE);
+    }
+    mt_run_mix(cases, test_pool, groups, count, test_duration);
+    mt_mix_free(groups, count);
+}
 
 int main(int argc, char *argv[])
 {
     parse_args(argc, argv);
-    if (!test_quiet)
+    test_pool = mt_pool_new(test_threads);
+    if (!test_quiet && mt_output_text())
     {
         printf("TEST                Rate\n");
     }
@@ -396,39 +333,40 @@ int main(int argc, char *argv[])
     {
         for (size_t i = 0; i < test_case_count; i++)
         {
-            size_t j;
-            for (j = 0; j < sizeof(test_functions) / sizeof(test_functions[0]); j++)
+            const struct cpu_case *function;
+            if (strchr(test_case_list[i], '+'))
+            {
+                run_test_mix(test_case_list[i]);
+                continue;
+            }
+            if (strcasecmp(test_case_list[i], "SYNC") == 0)
             {
-                if (strcasecmp(test_case_list[i], test_functions[j].name) == 0)
+                for (size_t j = 0; j < sizeof(sync_functions) / sizeof(sync_functions[0]); j++)
                 {
-                    struct mt_test_ops *ops = test_functions[j].ops;
-                    const uintptr_t *userdata = test_functions[j].userdata;
-                    size_t userdata_count = test_functions[j].userdata_count;
-
-                    double r = mt_run_all_simple(ops, test_threads, test_duration, userdata, userdata_count);
-                    printf("%-20s%.2f\n", test_functions[j].name, r);
-                    break;
+                    run_test_function(&sync_functions[j]);
                 }
+                continue;
             }
-            if (j == sizeof(test_functions) / sizeof(test_functions[0]))
+            function = find_test_function(test_case_list[i]);
+            if (!function)
             {
                 fprintf(stderr, "Unknown test case: %s\n", test_case_list[i]);
                 exit(EXIT_FAILURE);
             }
+            run_test_function(function);
         }
     }
     else
     {
-        for (size_t j = 0; j < sizeof(test_functions) / sizeof(test_functions[0]); j++)
-        {
-            struct mt_test_ops *ops = test_functions[j].ops;
-            const uintptr_t *userdata = test_functions[j].userdata;
-            size_t userdata_count = test_functions[j].userdata_count;
+        const struct cpu_case *list;
+        size_t count = cpu_cases(&list);
 
-            double r = mt_run_all_simple(ops, test_threads, test_duration, userdata, userdata_count);
-            printf("%-20s%.2f\n", test_functions[j].name, r);
+        for (size_t j = 0; j < count; j++)
+        {
+            run_test_function(&list[j]);
         }
     }
 
+    mt_pool_delete(test_pool);
     return 0;
 }
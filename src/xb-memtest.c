@@ -1,39 +1,19 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <time.h>
-#include <unistd.h>
 #include <getopt.h>
+#include <time.h>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 
-#ifdef HAVE_NUMA
-#include <numa.h>
-#endif
-
-static void *memtest_alloc(size_t size)
-{
-#ifdef HAVE_NUMA
-    if (numa_available() >= 0)
-    {
-        return numa_alloc_local(size);
-    }
-#endif
-    return malloc(size);
-}
-
-static void memtest_free(void *ptr, size_t size)
-{
-#ifdef HAVE_NUMA
-    if (numa_available() >= 0)
-    {
-        numa_free(ptr, size);
-        return;
-    }
-#endif
-    (void)size;
-    free(ptr);
-}
+#include "multitask.h"
+#include "multitask-stats.h"
+#include "memtest-simd.h"
+#include "cputest-cases.h"
 
 #ifndef MAGIC_NOT_ZERO
 #define MAGIC_NOT_ZERO 1
@@ -53,19 +33,6 @@ static void memtest_free(void *ptr, size_t size)
 #define TEST_DURATION 10
 #endif
 
-struct test_function
-{
-    const char *name;
-    void (*func)(void *, size_t);
-};
-
-struct test_result
-{
-    double best_rate;
-    double avg_rate;
-    double worst_rate;
-};
-
 static void test_copy(void *memory, size_t size)
 {
     size_t count = size / sizeof(uint64_t);
@@ -121,11 +88,6 @@ static void test_memcpy(void *memory, size_t size)
     memcpy(store_ptr, load_ptr, half * sizeof(uint64_t));
 }
 
-static double to_megabytes_per_second(size_t size, uint64_t duration)
-{
-    return (double)size / duration * 1000000000 / 1024 / 1024;
-}
-
 static void memtest_init(void *memory, size_t size)
 {
     size_t count = size / sizeof(uint64_t);
@@ -138,33 +100,128 @@ static void memtest_init(void *memory, size_t size)
 
 static unsigned int test_quiet;
 static unsigned int test_gb;
+static size_t test_mem_size;
 static unsigned int test_duration;
 static unsigned int test_threads;
+static unsigned int test_size_sweep;
+static unsigned int test_validate;
+// NUMA-MATRIX: cpu node the workers run on, -1 keeps the -p placement, and node of their memory
+#define TEST_NODE_DEFAULT -2                // mt_alloc with the -m policy
+#define TEST_NODE_INTERLEAVE -1
+static int test_cpu_node = -1;
+static int test_mem_node = TEST_NODE_DEFAULT;
+// LOADED: idle loop iterations the bandwidth workers wait after every cache line
+static unsigned int test_inject_delay;
+static unsigned int test_delay_default[] = {0, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 20000};
+static unsigned int *test_delay_list = test_delay_default;
+static size_t test_delay_count = sizeof(test_delay_default) / sizeof(test_delay_default[0]);
 
 static size_t test_case_count;
 static char **test_case_list;
+static struct mt_pool *test_pool;
 
 static void usage(FILE *f)
 {
+    const struct test_function *simd;
+    size_t simd_count = simd_test_functions(&simd);
+
     fprintf(f, "Usage: memtest [Options] [Cases...]\n"
                 "Options:\n"
                 "  -h            print this help\n"
                 "  -q            print less information\n"
                 "  -g <gb>       Specify the size of memory to test in GB\n"
                 "  -t <duration> Specify the duration to test\n"
-                "  -T <threads>  Specify the number of threads to test\n"
-                "Cases:\n"
+                "  -T <threads>  Specify the number of threads to test, a list like 1,2,4 or 1..N\n"
+                "                runs every count and reports speedup and scaling fits\n"
+                "  -S            sweep the working set of each thread from 4K up to the -G budget,\n"
+                "                doubling each step, and print a size by thread count table\n"
+                "  -V            validate the arrays of SCALE, ADD and TRIAD after every run\n"
+                "  -D <delays>   idle iterations after every cache line of the LOADED bandwidth\n"
+                "                workers, a list like 0,100,1000, one point each\n");
+    mt_usage_opts(f);
+    fprintf(f, "Cases:\n"
                 "  COPY          for loop copy memory from some where to another\n"
                 "  STORE         for loop store some value to memory\n"
                 "  LOAD          for loop load some value from memory\n"
                 "  MEMSET        test libc memset performance\n"
-                "  MEMCPY        test libc memcpy performance\n");
+                "  MEMCPY        test libc memcpy performance\n"
+                "  SCALE         STREAM b[i] = q * c[i] over double arrays, 2 arrays counted\n"
+                "  ADD           STREAM c[i] = a[i] + b[i], 3 arrays counted\n"
+                "  TRIAD         STREAM a[i] = b[i] + q * c[i], 3 arrays counted\n"
+                "                STREAM cases report MB/s of 10^6 bytes like STREAM, the others 2^20,\n"
+                "                run only when named, STREAM runs all three\n"
+                "  LATENCY       dependent loads over a random cycle, runs report loads/s,\n"
+                "                a table of ns per load follows\n"
+                "  LATENCY-PAGE  random order inside each 4K page, pages in order, a tlb miss per\n"
+                "                page instead of per load over a large working set\n"
+                "  LATENCY-SEQ   sequential order, shows what the prefetchers hide\n"
+                "  SIMD          scalar LOAD, STORE and COPY and every simd kernel of this cpu,\n"
+                "                followed by the ratio of each kernel to the scalar one\n"
+                "  STRIDE        one uint64_t load every 8 bytes up to every 16K, STRIDE-256 runs one\n"
+                "  GATHER        loads picked by a random index array\n"
+                "  SCATTER       stores picked by a random index array\n"
+                "                with the largest -T count, they report useful MB/s and cache lines/s\n"
+                "  FAULT         mmap, first touch of every 4K page and munmap of 64M chunks,\n"
+                "                FAULT-4K, FAULT-THP, FAULT-POPULATE and FAULT-REFAULT (MADV_DONTNEED)\n"
+                "                run one, /size replaces the chunk, a table of faults/s and time\n"
+                "                per phase follows\n"
+                "  LOADED        LATENCY of one worker while the other workers of the largest -T\n"
+                "                count load memory with every -D delay, reports latency against\n"
+                "                achieved bandwidth\n"
+                "  C2C           round trip of one cache line between every pair of allowed cpus,\n"
+                "                handed over with atomic stores, C2C-CAS with compare and swap,\n"
+                "                the median of -r runs per pair, -p is rejected, use taskset\n"
+                "  NUMA-MATRIX   LOAD bandwidth of the largest -T count and LATENCY of one thread\n"
+                "                for every cpu node and memory node, plus interleaved memory\n"
+                "Append /size to run a case with that working set per thread, like LOAD/64K,\n"
+                "LATENCY cases sweep the working set like -S unless /size is given and only run when named\n"
+                "Mixed cases may pair memory cases with the compute cases of xb-cputest, like STORE+PRIME:\n"
+                "  PRIME FIB XORSHIFT SORT-I32 SORT-U64 CIRCLE FPMAT-MUL FPMAT-CONV\n"
+                "SIMD kernels of this cpu, -NT streams stores past the cache, -PF prefetches loads:\n");
+    for (size_t i = 0; i < simd_count; i++)
+    {
+        fprintf(f, "%s%s", i % 6 ? " " : "  ", simd[i].name);
+        if (i % 6 == 5 || i + 1 == simd_count)
+        {
+            fprintf(f, "\n");
+        }
+    }
+}
+
+// comma separated injection delays of LOADED
+static void parse_delays(const char *arg)
+{
+    const char *p = arg;
+    size_t count = 1;
+
+    for (const char *c = arg; *c; c++)
+    {
+        count += *c == ',';
+    }
+    test_delay_list = (unsigned int *)malloc(sizeof(unsigned int) * count);
+    test_delay_count = 0;
+    while (1)
+    {
+        char *end;
+        unsigned long delay = strtoul(p, &end, 10);
+        if (end == p || (*end && *end != ','))
+        {
+            fprintf(stderr, "Invalid delay list: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        test_delay_list[test_delay_count++] = (unsigned int)delay;
+        if (!*end)
+        {
+            break;
+        }
+        p = end + 1;
+    }
 }
 
 static void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hqG:t:T:")) != -1)
+    while ((opt = getopt(argc, argv, "hqG:t:T:SVD:" MT_OPTSTRING)) != -1)
     {
         switch (opt)
         {
@@ -181,9 +238,22 @@ static void parse_args(int argc, char *argv[])
             test_duration = atoi(optarg);
             break;
         case 'T':
-            test_threads = atoi(optarg);
+            test_threads = mt_parse_threads(optarg);
+            break;
+        case 'S':
+            test_size_sweep = 1;
+            break;
+        case 'V':
+            test_validate = 1;
+            break;
+        case 'D':
+            parse_delays(optarg);
             break;
         default:
+            if (mt_parse_opt(opt, optarg))
+            {
+                break;
+            }
             usage(stderr);
             exit(EXIT_FAILURE);
         }
@@ -204,199 +274,1907 @@ static void parse_args(int argc, char *argv[])
     }
 }
 
-struct work_thread_data_shared
+// LOAD of every cache line followed by test_inject_delay idle iterations
+static void test_load_delay(void *memory, size_t size)
+{
+    const uint64_t *load_ptr = (const uint64_t *)memory;
+    unsigned int delay = test_inject_delay;
+    uint64_t sum = 0;
+    volatile uint64_t result;
+
+    for (size_t i = 0; i < size / 64; i++, load_ptr += 8)
+    {
+        sum ^= load_ptr[0] ^ load_ptr[1] ^ load_ptr[2] ^ load_ptr[3];
+        sum ^= load_ptr[4] ^ load_ptr[5] ^ load_ptr[6] ^ load_ptr[7];
+        for (unsigned int d = 0; d < delay; d++)
+        {
+            __asm__ volatile("");
+        }
+    }
+    result = sum;
+    (void)result;
+}
+
+// memory of one worker, called first in every prepare: for NUMA-MATRIX the worker moves to
+// test_cpu_node before it touches memory on test_mem_node
+static void *worker_alloc(size_t size)
+{
+    void *memory;
+
+    if (test_cpu_node >= 0 && mt_bind_node(test_cpu_node) != 0)
+    {
+        fprintf(stderr, "Cannot run on cpus of node %d\n", test_cpu_node);
+        exit(EXIT_FAILURE);
+    }
+    if (test_mem_node == TEST_NODE_DEFAULT)
+    {
+        return mt_alloc(size);
+    }
+    memory = mt_alloc_onnode(size, test_mem_node);
+    if (!memory)
+    {
+        fprintf(stderr, "Cannot allocate %zu bytes on node %d\n", size, test_mem_node);
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static void worker_free(void *memory, size_t size)
+{
+    if (test_mem_node == TEST_NODE_DEFAULT)
+    {
+        mt_free(memory, size);
+    }
+    else
+    {
+        mt_free_onnode(memory, size);
+    }
+    if (test_cpu_node >= 0)
+    {
+        mt_unbind_node();
+    }
+}
+
+// shared.userdata[0] = memtest function
+// shared.userdata[1] = memory size of each worker
+// data.userdata[0] = test memory
+// data.userdata[1] = offset of the next chunk to test
+
+static void memtest_prepare(struct mt_data *data)
+{
+    size_t mem_size = (size_t)data->shared->userdata[1];
+    void *memory = worker_alloc(mem_size);
+
+    memtest_init(memory, mem_size);
+    data->userdata[0] = (uintptr_t)memory;
+    data->userdata[1] = 0;
+}
+
+static void memtest_clean(struct mt_data *data)
+{
+    worker_free((void *)data->userdata[0], (size_t)data->shared->userdata[1]);
+}
+
+static void memtest_warmup(struct mt_data *data)
+{
+    void (*memtest_func)(void *, size_t) = (void (*)(void *, size_t))data->shared->userdata[0];
+    memtest_func((void *)data->userdata[0], (size_t)data->shared->userdata[1]);
+}
+
+static void memtest_test(struct mt_data *data)
+{
+    void (*memtest_func)(void *, size_t) = (void (*)(void *, size_t))data->shared->userdata[0];
+    size_t mem_size = (size_t)data->shared->userdata[1];
+    size_t offset = (size_t)data->userdata[1];
+    // test 32MB at most every call, so stop_flag is checked often enough
+    const size_t max_size = 32 * 1024 * 1024;
+
+    // small working sets repeat in one call so the call overhead stays out of cache bandwidth
+    if (mem_size < max_size)
+    {
+        size_t rounds = max_size / mem_size;
+        for (size_t i = 0; i < rounds; i++)
+        {
+            memtest_func((void *)data->userdata[0], mem_size);
+        }
+        mt_counter_add(data, rounds * mem_size);
+        return;
+    }
+
+    size_t remaining = mem_size - offset;
+    size_t size = remaining > max_size ? max_size : remaining;
+
+    memtest_func((uint8_t *)data->userdata[0] + offset, size);
+    offset += size;
+    data->userdata[1] = offset == mem_size ? 0 : offset;
+    mt_counter_add(data, size);
+}
+
+static struct mt_test_ops memtest_ops = {
+    .prepare = memtest_prepare,
+    .clean = memtest_clean,
+    .warmup = memtest_warmup,
+    .test = memtest_test,
+    .unit = "byte",
+};
+
+// a case with the working set of each worker, size 0 splits the -G budget among the workers
+struct test_case
 {
-    void (*memtest_func)(void *, size_t);
-    volatile unsigned int stop_flag;        // when set, worker thread should stop
-    pthread_mutex_t mutex;                  // protect worker_count and cond_m2w, cond_w2m
-    unsigned int worker_count;
-    unsigned int start_fence;
-    pthread_cond_t cond_m2w;                // main thread to worker thread
-    pthread_cond_t cond_w2m;                // worker thread to main thread
+    const void *function;
+    size_t size;
 };
 
-struct thread_data
+static double do_memory_test(const void *arg, unsigned int tasks, struct mt_result *result)
 {
-    unsigned int index;
-    pthread_t thread;
-    struct work_thread_data_shared *shared;
-    size_t mem_size;                        // usually 2GB
-    size_t worker_access_bytes;             // result of worker thread
+    const struct test_case *tc = (const struct test_case *)arg;
+    const struct test_function *function = (const struct test_function *)tc->function;
+    void (*memtest_func)(void *, size_t) = function->func;
+    size_t mem_size = test_mem_size;
+    size_t per_thread_size = tc->size ? tc->size : ((mem_size / tasks) & ~0x1ff);
+    uintptr_t userdata[] = {
+        (uintptr_t)memtest_func,
+        (uintptr_t)per_thread_size,
+    };
+    double r = mt_pool_run(test_pool, &memtest_ops, tasks, test_duration, userdata, sizeof(userdata) / sizeof(userdata[0]), result);
+
+    // bytes per second to MB/s
+    return r / 1024 / 1024;
+}
+
+static struct test_function test_functions[] = {
+    {"COPY", test_copy},
+    {"STORE", test_store},
+    {"LOAD", test_load},
+    {"MEMSET", test_memset},
+    {"MEMCPY", test_memcpy},
 };
 
-static void *memtest_thread_entry(void *arg)
+#define SWEEP_MIN_SIZE 4096
+
+// largest working set of each worker that fits the -G budget
+static size_t sweep_max_size(void)
 {
-    struct thread_data *data = (struct thread_data *)arg;
-    struct work_thread_data_shared *shared = data->shared;
-    void *mem_data = memtest_alloc(data->mem_size);
+    return (test_mem_size / test_threads) & ~(size_t)(SWEEP_MIN_SIZE - 1);
+}
 
-    // warmup
-    memtest_init(mem_data, data->mem_size);
-    shared->memtest_func(mem_data, data->mem_size);
-    pthread_mutex_lock(&shared->mutex);
-    shared->worker_count += 1;
-    pthread_cond_signal(&shared->cond_w2m);
-    pthread_mutex_unlock(&shared->mutex);
+// parse the size after '/', like 64K, 8M or 2G, return 0 if invalid
+static size_t parse_size(const char *str)
+{
+    char *end;
+    size_t size = strtoull(str, &end, 10);
 
-    // wait for start
-    pthread_mutex_lock(&shared->mutex);
-    while (!shared->start_fence)
+    switch (*end)
     {
-        pthread_cond_wait(&shared->cond_m2w, &shared->mutex);
+    case 'k':
+    case 'K':
+        size <<= 10;
+        end++;
+        break;
+    case 'm':
+    case 'M':
+        size <<= 20;
+        end++;
+        break;
+    case 'g':
+    case 'G':
+        size <<= 30;
+        end++;
+        break;
     }
-    pthread_mutex_unlock(&shared->mutex);
-
-    // run test until stop_flag is set
-    while (1)
+    if (end == str || *end || size < SWEEP_MIN_SIZE || size % SWEEP_MIN_SIZE)
     {
-        // check stop_flag every 32MB
-        uint8_t *data_p = (uint8_t *)mem_data;
-        size_t remaining = data->mem_size;
-        const size_t max_size = 32 * 1024 * 1024;
+        return 0;
+    }
+    return size;
+}
 
-        while (remaining)
-        {
-            size_t size = remaining > max_size ? max_size : remaining;
-            shared->memtest_func(data_p, size);
-            data_p += size;
-            remaining -= size;
-            data->worker_access_bytes += size;
-            if (shared->stop_flag)
-            {
-                goto out;
-            }
-        }
+// split "NAME/size" into the name length and the size, size 0 if there is no '/'
+static size_t parse_case_name(const char *name, size_t *size)
+{
+    const char *slash = strchr(name, '/');
 
+    *size = 0;
+    if (!slash)
+    {
+        return strlen(name);
+    }
+    if ((*size = parse_size(slash + 1)) == 0)
+    {
+        fprintf(stderr, "Invalid working set size in %s, need a multiple of 4K\n", name);
+        exit(EXIT_FAILURE);
+    }
+    if (*size > sweep_max_size())
+    {
+        fprintf(stderr, "Working set of %s exceeds %zu bytes per thread, raise -G\n", name, sweep_max_size());
+        exit(EXIT_FAILURE);
     }
-out:
+    return (size_t)(slash - name);
+}
 
-    pthread_mutex_lock(&shared->mutex);
-    shared->worker_count -= 1;
-    pthread_cond_signal(&shared->cond_w2m);
-    pthread_mutex_unlock(&shared->mutex);
-    memtest_free(mem_data, data->mem_size);
-    return NULL;
+// case name with its working set, like LOAD/64K
+static void size_case_name(char *buf, size_t len, const char *name, size_t size)
+{
+    char size_name[32];
+
+    mt_format_size(size_name, sizeof(size_name), size);
+    snprintf(buf, len, "%s/%s", name, size_name);
 }
 
-static double do_memory_test(size_t mem_size, void (*memtest_func)(void *, size_t))
+// working sets of a sweep, from 4K doubling up to the -G budget, return the count
+static unsigned int sweep_sizes(size_t *sizes, unsigned int max)
 {
-    struct work_thread_data_shared shared =
+    size_t max_size = sweep_max_size();
+    unsigned int count = 0;
+
+    for (size_t s = SWEEP_MIN_SIZE; s <= max_size && count < max; s *= 2)
     {
-        .memtest_func = memtest_func,
-        .mutex = PTHREAD_MUTEX_INITIALIZER,
-        .cond_m2w = PTHREAD_COND_INITIALIZER,
-        .cond_w2m = PTHREAD_COND_INITIALIZER,
-    };
-    struct thread_data *threads_data = (struct thread_data *)malloc(sizeof(struct thread_data) * test_threads);
-    size_t per_thread_size = ((mem_size / test_threads) & ~0xff);
-    size_t total_bytes = 0;
-    struct timespec start_time, end_time;
+        sizes[count++] = s;
+    }
+    return count;
+}
+
+// run function as name/size for every size and thread count,
+// rates[size * thread count + thread] gets the median rates
+static void run_sizes(const char *name, mt_case_func run, const void *function, double scale,
+                      const size_t *sizes, unsigned int count, double *rates)
+{
+    const unsigned int *threads;
+    unsigned int thread_count = mt_thread_counts(&threads);
+    char label[64];
 
-    for (size_t i = 0; i < test_threads; i++)
+    for (unsigned int i = 0; i < count; i++)
     {
-        threads_data[i].index = (unsigned int)i;
-        threads_data[i].shared = &shared;
-        threads_data[i].mem_size = per_thread_size;
-        threads_data[i].worker_access_bytes = 0;
-        pthread_create(&threads_data[i].thread, NULL, memtest_thread_entry, &threads_data[i]);
+        struct test_case tc = {function, sizes[i]};
+
+        size_case_name(label, sizeof(label), name, sizes[i]);
+        // the table is the summary, a scaling fit for every size would bury it
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            rates[i * thread_count + t] = mt_run_case_at(label, run, &tc, scale, threads[t]);
+        }
     }
+}
+
+// run function for every working set of the sweep and every thread count,
+// then print the rate of all of them as one table
+static void run_size_sweep(const char *name, mt_case_func run, const void *function, double scale, const char *unit)
+{
+    const unsigned int *threads;
+    unsigned int thread_count = mt_thread_counts(&threads);
+    size_t sizes[64];
+    unsigned int count = sweep_sizes(sizes, sizeof(sizes) / sizeof(sizes[0]));
+    double *rates = (double *)malloc(sizeof(double) * count * thread_count);
+
+    run_sizes(name, run, function, scale, sizes, count, rates);
+    mt_report_sizes(name, unit, sizes, count, rates);
+    free(rates);
+}
+
+static void run_test_function(const struct test_function *function, size_t size)
+{
+    struct test_case tc = {function, size};
+    char name[64];
 
-    // wait worker_count becames test_threads
-    pthread_mutex_lock(&shared.mutex);
-    while (shared.worker_count != test_threads)
+    if (test_size_sweep && !size)
+    {
+        run_size_sweep(function->name, do_memory_test, function, 1.0 / 1024 / 1024, "MB/s");
+        return;
+    }
+    if (size)
     {
-        pthread_cond_wait(&shared.cond_w2m, &shared.mutex);
+        size_case_name(name, sizeof(name), function->name, size);
+        mt_run_case(name, do_memory_test, &tc, 1.0 / 1024 / 1024);
+        return;
     }
-    pthread_mutex_unlock(&shared.mutex);
+    mt_run_case(function->name, do_memory_test, &tc, 1.0 / 1024 / 1024);
+}
 
-    // record start time
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
+// STREAM kernels over three double arrays a, b and c that split the memory of every worker,
+// bytes are counted the way STREAM does: every array touched once per element
+#define STREAM_SCALAR 3.0
+#define STREAM_A 1.0
+#define STREAM_B 2.0
+#define STREAM_C 0.5
+// elements of every array per test call, small arrays repeat until they reach it
+#define STREAM_CHUNK (1u << 20)
+// STREAM counts a MB as 10^6 bytes, the other cases as 2^20 bytes
+#define STREAM_MB_SCALE (1.0 / 1000000)
 
-    // notify all worker threads to start
-    pthread_mutex_lock(&shared.mutex);
-    shared.start_fence = 1;
-    pthread_cond_broadcast(&shared.cond_m2w);
-    pthread_mutex_unlock(&shared.mutex);
+enum
+{
+    STREAM_SCALE,
+    STREAM_ADD,
+    STREAM_TRIAD,
+};
 
+struct stream_function
+{
+    const char *name;
+    unsigned int kernel;
+    unsigned int arrays;                    // arrays read or written by the kernel
+};
 
-    // run test for test_duration seconds
-    sleep(test_duration);
+static struct stream_function stream_functions[] = {
+    {"SCALE", STREAM_SCALE, 2},
+    {"ADD", STREAM_ADD, 3},
+    {"TRIAD", STREAM_TRIAD, 3},
+};
 
-    // notify all worker threads to stop
-    shared.stop_flag = 1;
+static size_t stream_errors;
 
-    // wait worker_count becames 0
-    pthread_mutex_lock(&shared.mutex);
-    while (shared.worker_count != 0)
+static void stream_scale(double *restrict b, const double *restrict c, size_t n)
+{
+    for (size_t j = 0; j < n; j++)
     {
-        pthread_cond_wait(&shared.cond_w2m, &shared.mutex);
+        b[j] = STREAM_SCALAR * c[j];
     }
-    pthread_mutex_unlock(&shared.mutex);
+}
 
-    // record end time
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
+static void stream_add(double *restrict c, const double *restrict a, const double *restrict b, size_t n)
+{
+    for (size_t j = 0; j < n; j++)
+    {
+        c[j] = a[j] + b[j];
+    }
+}
 
-    // release threads_data
-    for (size_t i = 0; i < test_threads; i++)
+static void stream_triad(double *restrict a, const double *restrict b, const double *restrict c, size_t n)
+{
+    for (size_t j = 0; j < n; j++)
     {
-        pthread_join(threads_data[i].thread, NULL);
-        total_bytes += threads_data[i].worker_access_bytes;
+        a[j] = b[j] + STREAM_SCALAR * c[j];
     }
-    free(threads_data);
+}
 
-    uint64_t elapsed_time = (end_time.tv_sec - start_time.tv_sec) * 1000000000 + (end_time.tv_nsec - start_time.tv_nsec);
-    return to_megabytes_per_second(total_bytes, elapsed_time);
+// elements of each array, a multiple of 8 so that every array starts on a cache line
+static size_t stream_elements(size_t size)
+{
+    return size / 3 / sizeof(double) & ~(size_t)7;
 }
 
-static struct test_function test_functions[] = {
-    {"COPY", test_copy},
-    {"STORE", test_store},
-    {"LOAD", test_load},
-    {"MEMSET", test_memset},
-    {"MEMCPY", test_memcpy},
-};
+static void stream_run(unsigned int kernel, double *memory, size_t n, size_t offset, size_t count)
+{
+    double *a = memory + offset;
+    double *b = memory + n + offset;
+    double *c = memory + 2 * n + offset;
 
-int main(int argc, char *argv[])
+    switch (kernel)
+    {
+    case STREAM_SCALE:
+        stream_scale(b, c, count);
+        break;
+    case STREAM_ADD:
+        stream_add(c, a, b, count);
+        break;
+    default:
+        stream_triad(a, b, c, count);
+        break;
+    }
+}
+
+// shared.userdata[0] = stream function
+// shared.userdata[1] = memory size of each worker
+// data.userdata[0] = the three arrays
+// data.userdata[1] = element offset of the next chunk to test
+
+static void stream_prepare(struct mt_data *data)
 {
-    double r;
-    size_t mem_size;
-    size_t function_count = sizeof(test_functions) / sizeof(test_functions[0]);
+    size_t mem_size = (size_t)data->shared->userdata[1];
+    size_t n = stream_elements(mem_size);
+    double *memory = (double *)worker_alloc(mem_size);
 
-    parse_args(argc, argv);
-    mem_size = 1024ull * 1024ull * 1024ull * test_gb;
+    // first touch by the worker, like the memtest buffers
+    for (size_t j = 0; j < n; j++)
+    {
+        memory[j] = STREAM_A;
+        memory[n + j] = STREAM_B;
+        memory[2 * n + j] = STREAM_C;
+    }
+    data->userdata[0] = (uintptr_t)memory;
+    data->userdata[1] = 0;
+}
+
+// every kernel runs alone and never writes its own inputs, so each array must hold one value
+static void stream_validate(const struct stream_function *function, const double *memory, size_t n)
+{
+    double expect[3] = {STREAM_A, STREAM_B, STREAM_C};
+    size_t errors = 0;
 
-    if (!test_quiet)
+    switch (function->kernel)
     {
-        printf("MAGIC_NOT_ZERO=%d test_gb=%u\n", MAGIC_NOT_ZERO, test_gb);
-        printf("TEST                Rate(MB/s)\n");
+    case STREAM_SCALE:
+        expect[1] = STREAM_SCALAR * STREAM_C;
+        break;
+    case STREAM_ADD:
+        expect[2] = STREAM_A + STREAM_B;
+        break;
+    default:
+        expect[0] = STREAM_B + STREAM_SCALAR * STREAM_C;
+        break;
     }
-    if (test_case_count > 0)
+    for (size_t k = 0; k < 3; k++)
     {
-        for (size_t i = 0; i < test_case_count; i++)
+        for (size_t j = 0; j < n; j++)
         {
-            size_t j;
-            for (j = 0; j < function_count; j++)
+            double diff = memory[k * n + j] - expect[k];
+            // same relative bound as the STREAM check for double
+            if (diff > expect[k] * 1e-13 || diff < -expect[k] * 1e-13)
             {
-                if (strcasecmp(test_case_list[i], test_functions[j].name) == 0)
-                {
-                    r = do_memory_test(mem_size, test_functions[j].func);
-                    printf("%-20s%.2f\n", test_functions[j].name, r);
-                    break;
-                }
-            }
-            if (j == function_count)
-            {
-                fprintf(stderr, "Unknown test case: %s\n", test_case_list[i]);
-                exit(EXIT_FAILURE);
+                errors++;
             }
         }
     }
-    else
+    if (errors)
     {
-        for (size_t i = 0; i < function_count; i++)
+        __atomic_add_fetch(&stream_errors, errors, __ATOMIC_RELAXED);
+    }
+}
+
+static void stream_clean(struct mt_data *data)
+{
+    const struct stream_function *function = (const struct stream_function *)data->shared->userdata[0];
+    size_t mem_size = (size_t)data->shared->userdata[1];
+
+    if (test_validate)
+    {
+        stream_validate(function, (const double *)data->userdata[0], stream_elements(mem_size));
+    }
+    worker_free((void *)data->userdata[0], mem_size);
+}
+
+static void stream_warmup(struct mt_data *data)
+{
+    const struct stream_function *function = (const struct stream_function *)data->shared->userdata[0];
+    size_t n = stream_elements((size_t)data->shared->userdata[1]);
+
+    stream_run(function->kernel, (double *)data->userdata[0], n, 0, n);
+}
+
+static void stream_test(struct mt_data *data)
+{
+    const struct stream_function *function = (const struct stream_function *)data->shared->userdata[0];
+    size_t n = stream_elements((size_t)data->shared->userdata[1]);
+    size_t offset = (size_t)data->userdata[1];
+    size_t count;
+
+    if (n < STREAM_CHUNK)
+    {
+        size_t rounds = STREAM_CHUNK / n;
+        for (size_t i = 0; i < rounds; i++)
         {
-            r = do_memory_test(mem_size, test_functions[i].func);
-            printf("%-20s%.2f\n", test_functions[i].name, r);
+            stream_run(function->kernel, (double *)data->userdata[0], n, 0, n);
         }
+        mt_counter_add(data, rounds * n * function->arrays * sizeof(double));
+        return;
+    }
+    count = n - offset < STREAM_CHUNK ? n - offset : STREAM_CHUNK;
+    stream_run(function->kernel, (double *)data->userdata[0], n, offset, count);
+    offset += count;
+    data->userdata[1] = offset == n ? 0 : offset;
+    mt_counter_add(data, count * function->arrays * sizeof(double));
+}
+
+static struct mt_test_ops stream_ops = {
+    .prepare = stream_prepare,
+    .clean = stream_clean,
+    .warmup = stream_warmup,
+    .test = stream_test,
+    .unit = "byte",
+};
+
+static double do_stream_test(const void *arg, unsigned int tasks, struct mt_result *result)
+{
+    const struct test_case *tc = (const struct test_case *)arg;
+    const struct stream_function *function = (const struct stream_function *)tc->function;
+    size_t per_thread_size = tc->size ? tc->size : ((test_mem_size / tasks) & ~0x1ff);
+    uintptr_t userdata[] = {
+        (uintptr_t)function,
+        (uintptr_t)per_thread_size,
+    };
+    double r;
+
+    stream_errors = 0;
+    r = mt_pool_run(test_pool, &stream_ops, tasks, test_duration, userdata, sizeof(userdata) / sizeof(userdata[0]), result);
+    if (stream_errors)
+    {
+        fprintf(stderr, "%s validation failed: %zu elements differ\n", function->name, stream_errors);
+        exit(EXIT_FAILURE);
+    }
+    // bytes per second to STREAM MB/s
+    return r * STREAM_MB_SCALE;
+}
+
+static void run_stream_function(const struct stream_function *function, size_t size)
+{
+    struct test_case tc = {function, size};
+    char name[64];
+
+    if (test_size_sweep && !size)
+    {
+        run_size_sweep(function->name, do_stream_test, function, STREAM_MB_SCALE, "MB/s of 10^6 bytes");
+        return;
+    }
+    if (size)
+    {
+        size_case_name(name, sizeof(name), function->name, size);
+        mt_run_case(name, do_stream_test, &tc, STREAM_MB_SCALE);
+        return;
     }
+    mt_run_case(function->name, do_stream_test, &tc, STREAM_MB_SCALE);
+}
+
+// LATENCY cases chase a cyclic chain of cache line sized nodes, every load
+// depends on the previous one, so the rate is the inverse of the load latency
+#define LATENCY_LINE 64
+#define LATENCY_PAGE 4096
+// dependent loads every test call, about 6ms when every load misses to dram
+#define LATENCY_STEPS 65536
+// warm-up walks the chain once, at most this many loads
+#define LATENCY_WARMUP_STEPS (4u << 20)
+
+enum
+{
+    LATENCY_SEQUENTIAL,                     // next line, prefetchers hide most of the latency
+    LATENCY_PAGE_RANDOM,                    // random lines inside a page, pages in order: one tlb miss per page, not per load
+    LATENCY_RANDOM,                         // random lines over the whole working set
+};
+
+struct latency_function
+{
+    const char *name;
+    unsigned int order;
+};
+
+struct latency_node
+{
+    uintptr_t next;                         // index while the chain is built, then a pointer
+    uint8_t pad[LATENCY_LINE - sizeof(uintptr_t)];
+};
+
+static struct latency_function latency_functions[] = {
+    {"LATENCY", LATENCY_RANDOM},
+    {"LATENCY-PAGE", LATENCY_PAGE_RANDOM},
+    {"LATENCY-SEQ", LATENCY_SEQUENTIAL},
+};
+
+static uint64_t latency_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// link the nodes of memory into one cycle visiting every node once
+static void latency_build(void *memory, size_t size, unsigned int order, uint64_t seed)
+{
+    struct latency_node *nodes = (struct latency_node *)memory;
+    size_t count = size / LATENCY_LINE;
+    uint64_t state = seed | 1;
+
+    if (order == LATENCY_SEQUENTIAL)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            nodes[i].next = (uintptr_t)&nodes[(i + 1) % count];
+        }
+    }
+    else if (order == LATENCY_PAGE_RANDOM)
+    {
+        size_t lines = LATENCY_PAGE / LATENCY_LINE;
+        size_t slot[LATENCY_PAGE / LATENCY_LINE];
+        struct latency_node *prev = NULL;
+        struct latency_node *first = NULL;
+
+        for (size_t page = 0; page < count; page += lines)
+        {
+            for (size_t k = 0; k < lines; k++)
+            {
+                slot[k] = page + k;
+            }
+            // fisher-yates shuffle of the lines of this page
+            for (size_t k = lines - 1; k > 0; k--)
+            {
+                size_t j = latency_random(&state) % (k + 1);
+                size_t t = slot[k];
+                slot[k] = slot[j];
+                slot[j] = t;
+            }
+            for (size_t k = 0; k < lines; k++)
+            {
+                if (prev)
+                {
+                    prev->next = (uintptr_t)&nodes[slot[k]];
+                }
+                else
+                {
+                    first = &nodes[slot[k]];
+                }
+                prev = &nodes[slot[k]];
+            }
+        }
+        prev->next = (uintptr_t)first;
+    }
+    else
+    {
+        // sattolo's algorithm in place: node i links to node next[i], one single cycle
+        for (size_t i = 0; i < count; i++)
+        {
+            nodes[i].next = i;
+        }
+        for (size_t i = count - 1; i > 0; i--)
+        {
+            size_t j = latency_random(&state) % i;
+            uintptr_t t = nodes[i].next;
+            nodes[i].next = nodes[j].next;
+            nodes[j].next = t;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            nodes[i].next = (uintptr_t)&nodes[nodes[i].next];
+        }
+    }
+}
+
+static struct latency_node *latency_walk(struct latency_node *node, size_t steps)
+{
+    for (size_t i = 0; i < steps; i++)
+    {
+        node = (struct latency_node *)node->next;
+    }
+    return node;
+}
+
+// shared.userdata[0] = chain order
+// shared.userdata[1] = working set size of each worker
+// data.userdata[0] = chain memory
+// data.userdata[1] = current node of the chain
+
+static void latency_prepare(struct mt_data *data)
+{
+    unsigned int order = (unsigned int)data->shared->userdata[0];
+    size_t size = (size_t)data->shared->userdata[1];
+    void *memory = worker_alloc(size);
+
+    latency_build(memory, size, order, 0x9e3779b97f4a7c15ull * (data->index + 1));
+    data->userdata[0] = (uintptr_t)memory;
+    data->userdata[1] = (uintptr_t)memory;
+}
+
+static void latency_clean(struct mt_data *data)
+{
+    worker_free((void *)data->userdata[0], (size_t)data->shared->userdata[1]);
+}
+
+static void latency_warmup(struct mt_data *data)
+{
+    size_t count = (size_t)data->shared->userdata[1] / LATENCY_LINE;
+    size_t steps = count < LATENCY_WARMUP_STEPS ? count : LATENCY_WARMUP_STEPS;
+
+    data->userdata[1] = (uintptr_t)latency_walk((struct latency_node *)data->userdata[1], steps);
+}
+
+static void latency_test(struct mt_data *data)
+{
+    // storing the last node keeps the walk alive and resumes it on the next call
+    data->userdata[1] = (uintptr_t)latency_walk((struct latency_node *)data->userdata[1], LATENCY_STEPS);
+    mt_counter_add(data, LATENCY_STEPS);
+}
+
+static struct mt_test_ops latency_ops = {
+    .prepare = latency_prepare,
+    .clean = latency_clean,
+    .warmup = latency_warmup,
+    .test = latency_test,
+    .unit = "load",
+};
+
+static double do_latency_test(const void *arg, unsigned int tasks, struct mt_result *result)
+{
+    const struct test_case *tc = (const struct test_case *)arg;
+    const struct latency_function *function = (const struct latency_function *)tc->function;
+    uintptr_t userdata[] = {
+        (uintptr_t)function->order,
+        (uintptr_t)(tc->size ? tc->size : sweep_max_size()),
+    };
+    // loads per second of all workers, higher is better like every other rate of the harness
+    return mt_pool_run(test_pool, &latency_ops, tasks, test_duration, userdata, sizeof(userdata) / sizeof(userdata[0]), result);
+}
+
+// every worker walks its own chain: loads per second of tasks workers to ns per load
+static double latency_ns(double rate, unsigned int tasks)
+{
+    return rate > 0 ? tasks * 1e9 / rate : 0;
+}
+
+// find the bandwidth case of name, "LOAD" or "LOAD/64K", size 0 if not given
+static const struct test_function *lookup_memory_function(const char *name, size_t *size)
+{
+    size_t len = parse_case_name(name, size);
+    const struct test_function *simd;
+    size_t simd_count = simd_test_functions(&simd);
+
+    for (size_t j = 0; j < sizeof(test_functions) / sizeof(test_functions[0]); j++)
+    {
+        if (strlen(test_functions[j].name) == len && strncasecmp(name, test_functions[j].name, len) == 0)
+        {
+            return &test_functions[j];
+        }
+    }
+    for (size_t j = 0; j < simd_count; j++)
+    {
+        if (strlen(simd[j].name) == len && strncasecmp(name, simd[j].name, len) == 0)
+        {
+            return &simd[j];
+        }
+    }
+    return NULL;
+}
+
+// scalar LOAD, STORE and COPY, then every simd kernel of this cpu with its ratio to the
+// scalar kernel of the same operation
+static void run_simd_report(void)
+{
+    const char *scalar[] = {"LOAD", "STORE", "COPY"};
+    const unsigned int *threads;
+    unsigned int thread_count = mt_thread_counts(&threads);
+    const struct test_function *simd;
+    size_t simd_count = simd_test_functions(&simd);
+    size_t scalar_count = sizeof(scalar) / sizeof(scalar[0]);
+    double *rates = (double *)malloc(sizeof(double) * (scalar_count + simd_count) * thread_count);
+    char label[32];
+
+    for (size_t i = 0; i < scalar_count + simd_count; i++)
+    {
+        size_t size;
+        const struct test_function *function = i < scalar_count ? lookup_memory_function(scalar[i], &size)
+                                                                 : &simd[i - scalar_count];
+        struct test_case tc = {function, 0};
+        mt_run_case_rates(function->name, do_memory_test, &tc, 1.0 / 1024 / 1024, &rates[i * thread_count]);
+    }
+    if (!mt_output_text())
+    {
+        free(rates);
+        return;
+    }
+
+    printf("SIMD kernels against scalar, MB/s\n");
+    printf("  %-20s", "kernel");
+    for (unsigned int t = 0; t < thread_count; t++)
+    {
+        snprintf(label, sizeof(label), "T=%u", threads[t]);
+        printf("%-22s", label);
+    }
+    printf("\n");
+    for (size_t i = 0; i < scalar_count + simd_count; i++)
+    {
+        const char *name = i < scalar_count ? scalar[i] : simd[i - scalar_count].name;
+        size_t base = 0;
+
+        // the scalar baseline shares the operation prefix, like LOAD of LOAD-AVX2-PF
+        for (size_t k = 0; k < scalar_count; k++)
+        {
+            size_t len = strlen(scalar[k]);
+            if (strncmp(name, scalar[k], len) == 0 && (name[len] == '-' || name[len] == 0))
+            {
+                base = k;
+            }
+        }
+        printf("  %-20s", name);
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            double ref = rates[base * thread_count + t];
+            snprintf(label, sizeof(label), "x%.2f", ref > 0 ? rates[i * thread_count + t] / ref : 0);
+            printf("%-14.2f%-8s", rates[i * thread_count + t], label);
+        }
+        printf("\n");
+    }
+    free(rates);
+}
+
+// find the STREAM case of name, "TRIAD" or "TRIAD/64K", size 0 if not given
+static const struct stream_function *lookup_stream_function(const char *name, size_t *size)
+{
+    size_t len = parse_case_name(name, size);
+
+    for (size_t j = 0; j < sizeof(stream_functions) / sizeof(stream_functions[0]); j++)
+    {
+        if (strlen(stream_functions[j].name) == len && strncasecmp(name, stream_functions[j].name, len) == 0)
+        {
+            return &stream_functions[j];
+        }
+    }
+    return NULL;
+}
+
+// find the latency case of name, "LATENCY" or "LATENCY/64K", size 0 if not given
+static const struct latency_function *lookup_latency_function(const char *name, size_t *size)
+{
+    size_t len = parse_case_name(name, size);
+
+    for (size_t j = 0; j < sizeof(latency_functions) / sizeof(latency_functions[0]); j++)
+    {
+        if (strlen(latency_functions[j].name) == len && strncasecmp(name, latency_functions[j].name, len) == 0)
+        {
+            return &latency_functions[j];
+        }
+    }
+    return NULL;
+}
+
+// runs are printed in loads/s, the table that follows converts them to ns per load,
+// without a size a latency case always sweeps, one working set gives no curve
+static void run_latency_function(const struct latency_function *function, size_t size)
+{
+    const unsigned int *threads;
+    unsigned int thread_count = mt_thread_counts(&threads);
+    size_t sizes[64];
+    unsigned int count = 1;
+    double *rates;
+
+    sizes[0] = size;
+    if (!size)
+    {
+        count = sweep_sizes(sizes, sizeof(sizes) / sizeof(sizes[0]));
+    }
+    rates = (double *)malloc(sizeof(double) * count * thread_count);
+    run_sizes(function->name, do_latency_test, function, 1.0, sizes, count, rates);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            rates[i * thread_count + t] = latency_ns(rates[i * thread_count + t], threads[t]);
+        }
+    }
+    mt_report_sizes(function->name, "ns/load", sizes, count, rates);
+    free(rates);
+}
+
+// STRIDE cases load one uint64_t every stride bytes, GATHER and SCATTER load or store the
+// uint64_t picked by a precomputed random index array, the rate counts the 8 useful bytes
+// of every access, the cache lines behind them follow from the pattern
+enum
+{
+    PATTERN_STRIDE,
+    PATTERN_GATHER,
+    PATTERN_SCATTER,
+};
+
+struct pattern_function
+{
+    const char *name;
+    unsigned int kind;
+    size_t stride;                          // bytes between two loads of STRIDE
+};
+
+static struct pattern_function pattern_functions[] = {
+    {"STRIDE-8", PATTERN_STRIDE, 8},
+    {"STRIDE-16", PATTERN_STRIDE, 16},
+    {"STRIDE-32", PATTERN_STRIDE, 32},
+    {"STRIDE-64", PATTERN_STRIDE, 64},
+    {"STRIDE-128", PATTERN_STRIDE, 128},
+    {"STRIDE-256", PATTERN_STRIDE, 256},
+    {"STRIDE-512", PATTERN_STRIDE, 512},
+    {"STRIDE-1024", PATTERN_STRIDE, 1024},
+    {"STRIDE-2048", PATTERN_STRIDE, 2048},
+    {"STRIDE-4096", PATTERN_STRIDE, 4096},
+    {"STRIDE-8192", PATTERN_STRIDE, 8192},
+    {"STRIDE-16384", PATTERN_STRIDE, 16384},
+    {"GATHER", PATTERN_GATHER, 0},
+    {"SCATTER", PATTERN_SCATTER, 0},
+};
+
+// accesses every test call
+#define PATTERN_ACCESSES (1u << 20)
+// index array of GATHER and SCATTER, at most a quarter of the worker memory
+#define PATTERN_MAX_INDICES (1u << 24)
+
+// cache lines touched by every access
+static double pattern_lines(const struct pattern_function *function)
+{
+    if (function->kind == PATTERN_STRIDE && function->stride < 64)
+    {
+        return function->stride / 64.0;
+    }
+    return 1.0;
+}
+
+static size_t pattern_indices(size_t size)
+{
+    return size / 16 < PATTERN_MAX_INDICES ? size / 16 : PATTERN_MAX_INDICES;
+}
+
+// data elements after the index array, capped to what a 32 bit index reaches
+static size_t pattern_elements(size_t size, size_t indices)
+{
+    size_t elements = (size - indices * sizeof(uint32_t)) / sizeof(uint64_t);
+    return elements < UINT32_MAX ? elements : UINT32_MAX;
+}
+
+// shared.userdata[0] = pattern function
+// shared.userdata[1] = memory size of each worker
+// data.userdata[0] = test memory, GATHER and SCATTER keep their indices at the start
+// data.userdata[1] = byte offset of the next STRIDE load, or the next index
+// data.userdata[2] = byte offset the current STRIDE pass started at
+// data.userdata[3] = sum of the loads, keeps them alive
+
+static void pattern_prepare(struct mt_data *data)
+{
+    const struct pattern_function *function = (const struct pattern_function *)data->shared->userdata[0];
+    size_t mem_size = (size_t)data->shared->userdata[1];
+    void *memory = worker_alloc(mem_size);
+
+    memtest_init(memory, mem_size);
+    if (function->kind != PATTERN_STRIDE)
+    {
+        size_t indices = pattern_indices(mem_size);
+        size_t elements = pattern_elements(mem_size, indices);
+        uint32_t *index = (uint32_t *)memory;
+        uint64_t state = 0x9e3779b97f4a7c15ull * (data->index + 1);
+
+        for (size_t i = 0; i < indices; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            index[i] = (uint32_t)(state % elements);
+        }
+    }
+    data->userdata[0] = (uintptr_t)memory;
+    data->userdata[1] = 0;
+    data->userdata[2] = 0;
+    data->userdata[3] = 0;
+}
+
+static void pattern_clean(struct mt_data *data)
+{
+    worker_free((void *)data->userdata[0], (size_t)data->shared->userdata[1]);
+}
+
+static void pattern_stride(struct mt_data *data, size_t stride, size_t size, size_t accesses)
+{
+    const uint8_t *memory = (const uint8_t *)data->userdata[0];
+    size_t offset = (size_t)data->userdata[1];
+    size_t start = (size_t)data->userdata[2];
+    uint64_t sum = (uint64_t)data->userdata[3];
+
+    while (accesses)
+    {
+        size_t run = (size - offset + stride - 1) / stride;
+        if (run > accesses)
+        {
+            run = accesses;
+        }
+        for (size_t i = 0; i < run; i++, offset += stride)
+        {
+            sum += *(const uint64_t *)(memory + offset);
+        }
+        accesses -= run;
+        if (offset >= size)
+        {
+            // the next pass moves to the next cache line of every stride, so the whole buffer is used
+            start = stride > 64 ? (start + 64) % stride : 0;
+            offset = start;
+        }
+    }
+    data->userdata[1] = offset;
+    data->userdata[2] = start;
+    data->userdata[3] = sum;
+}
+
+static void pattern_indexed(struct mt_data *data, unsigned int kind, size_t size, size_t accesses)
+{
+    size_t indices = pattern_indices(size);
+    const uint32_t *index = (const uint32_t *)data->userdata[0];
+    uint64_t *elements = (uint64_t *)(index + indices);
+    size_t next = (size_t)data->userdata[1];
+    uint64_t sum = (uint64_t)data->userdata[3];
+
+    while (accesses)
+    {
+        size_t run = indices - next < accesses ? indices - next : accesses;
+        if (kind == PATTERN_GATHER)
+        {
+            for (size_t i = next; i < next + run; i++)
+            {
+                sum += elements[index[i]];
+            }
+        }
+        else
+        {
+            for (size_t i = next; i < next + run; i++)
+            {
+                elements[index[i]] = i;
+            }
+        }
+        accesses -= run;
+        next = next + run == indices ? 0 : next + run;
+    }
+    data->userdata[1] = next;
+    data->userdata[3] = sum;
+}
+
+static void pattern_run(struct mt_data *data, size_t accesses)
+{
+    const struct pattern_function *function = (const struct pattern_function *)data->shared->userdata[0];
+    size_t mem_size = (size_t)data->shared->userdata[1];
+
+    if (function->kind == PATTERN_STRIDE)
+    {
+        pattern_stride(data, function->stride, mem_size & ~(size_t)7, accesses);
+    }
+    else
+    {
+        pattern_indexed(data, function->kind, mem_size, accesses);
+    }
+}
+
+static void pattern_warmup(struct mt_data *data)
+{
+    pattern_run(data, PATTERN_ACCESSES);
+}
+
+static void pattern_test(struct mt_data *data)
+{
+    pattern_run(data, PATTERN_ACCESSES);
+    mt_counter_add(data, PATTERN_ACCESSES * sizeof(uint64_t));
+}
+
+static struct mt_test_ops pattern_ops = {
+    .prepare = pattern_prepare,
+    .clean = pattern_clean,
+    .warmup = pattern_warmup,
+    .test = pattern_test,
+    .unit = "byte",
+};
+
+static double do_pattern_test(const void *arg, unsigned int tasks, struct mt_result *result)
+{
+    const struct test_case *tc = (const struct test_case *)arg;
+    size_t per_thread_size = tc->size ? tc->size : ((test_mem_size / tasks) & ~0x1ff);
+    uintptr_t userdata[] = {
+        (uintptr_t)tc->function,
+        (uintptr_t)per_thread_size,
+    };
+    double r = mt_pool_run(test_pool, &pattern_ops, tasks, test_duration, userdata, sizeof(userdata) / sizeof(userdata[0]), result);
+
+    // useful bytes per second to MB/s
+    return r / 1024 / 1024;
+}
+
+// run pattern functions whose name starts with prefix, "STRIDE" runs every stride,
+// then print useful bandwidth, cache lines per second and the share of STRIDE-8
+static void run_pattern_functions(const char *prefix, size_t size)
+{
+    size_t count = sizeof(pattern_functions) / sizeof(pattern_functions[0]);
+    size_t len = strlen(prefix);
+    const char *rows[sizeof(pattern_functions) / sizeof(pattern_functions[0])];
+    const char *cols[] = {"MB/s", "Mlines/s", "of STRIDE-8"};
+    double values[sizeof(pattern_functions) / sizeof(pattern_functions[0]) * 3];
+    char names[sizeof(pattern_functions) / sizeof(pattern_functions[0])][64];
+    unsigned int row_count = 0;
+    double sequential = 0;
+
+    for (size_t j = 0; j < count; j++)
+    {
+        const struct pattern_function *function = &pattern_functions[j];
+        struct test_case tc = {function, size};
+        double rate;
+
+        if (strncasecmp(function->name, prefix, len) != 0 || (function->name[len] && function->name[len] != '-'))
+        {
+            continue;
+        }
+        if (size)
+        {
+            size_case_name(names[row_count], sizeof(names[row_count]), function->name, size);
+        }
+        else
+        {
+            snprintf(names[row_count], sizeof(names[row_count]), "%s", function->name);
+        }
+        rate = mt_run_case_at(names[row_count], do_pattern_test, &tc, 1.0 / 1024 / 1024, test_threads);
+        if (function->kind == PATTERN_STRIDE && function->stride == 8)
+        {
+            sequential = rate;
+        }
+        rows[row_count] = names[row_count];
+        values[row_count * 3] = rate;
+        values[row_count * 3 + 1] = rate * 1024 * 1024 / sizeof(uint64_t) * pattern_lines(function) / 1000000;
+        values[row_count * 3 + 2] = 0;
+        row_count++;
+    }
+    if (sequential > 0)
+    {
+        for (unsigned int r = 0; r < row_count; r++)
+        {
+            values[r * 3 + 2] = values[r * 3] / sequential;
+        }
+        mt_report_matrix(prefix, "access pattern", "per second", rows, row_count, cols, 3, values);
+        return;
+    }
+    // without STRIDE-8 there is no sequential reference, drop the last column
+    for (unsigned int r = 0; r < row_count; r++)
+    {
+        values[r * 2] = values[r * 3];
+        values[r * 2 + 1] = values[r * 3 + 1];
+    }
+    mt_report_matrix(prefix, "access pattern", "per second", rows, row_count, cols, 2, values);
+}
+
+// copy the pattern case of name without its /size to prefix, return 0 if no pattern function matches
+static int lookup_pattern_function(const char *name, char *prefix, size_t prefix_len, size_t *size)
+{
+    size_t len = parse_case_name(name, size);
+
+    if (len >= prefix_len)
+    {
+        return 0;
+    }
+    memcpy(prefix, name, len);
+    prefix[len] = 0;
+    for (size_t j = 0; j < sizeof(pattern_functions) / sizeof(pattern_functions[0]); j++)
+    {
+        const char *candidate = pattern_functions[j].name;
+        if (strncasecmp(candidate, prefix, len) == 0 && (candidate[len] == 0 || candidate[len] == '-'))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// FAULT cases time how fast a worker gets fresh memory: map a chunk, write every 4K page once
+// and unmap it again, FAULT-REFAULT keeps the mapping and drops its pages with MADV_DONTNEED,
+// the rate counts the bytes made usable, faults come from the minor fault count of the thread
+enum
+{
+    FAULT_4K,                               // MADV_NOHUGEPAGE, one fault every 4K
+    FAULT_THP,                              // 2M aligned with MADV_HUGEPAGE
+    FAULT_POPULATE,                         // MAP_POPULATE faults everything inside mmap
+    FAULT_REFAULT,                          // MADV_DONTNEED, then 4K faults on the same mapping
+};
+
+struct fault_function
+{
+    const char *name;
+    unsigned int kind;
+};
+
+static struct fault_function fault_functions[] = {
+    {"FAULT-4K", FAULT_4K},
+    {"FAULT-THP", FAULT_THP},
+    {"FAULT-POPULATE", FAULT_POPULATE},
+    {"FAULT-REFAULT", FAULT_REFAULT},
+};
+
+#define FAULT_PAGE 4096
+#define FAULT_HUGE_PAGE (2ul * 1024 * 1024)
+// memory every test call maps and touches, less if -G is smaller
+#define FAULT_CHUNK (64ul * 1024 * 1024)
+
+// time split of the calls of every worker count, summed over all workers and runs
+struct fault_stats
+{
+    uint64_t bytes;
+    uint64_t faults;
+    uint64_t map_ns;
+    uint64_t touch_ns;
+    uint64_t unmap_ns;
+};
+
+static struct fault_stats *fault_totals;    // indexed by worker count
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t fault_thread_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return (uint64_t)usage.ru_minflt;
+}
+
+static void fault_touch(uint8_t *memory, size_t size)
+{
+    for (size_t offset = 0; offset < size; offset += FAULT_PAGE)
+    {
+        *(volatile uint8_t *)(memory + offset) = 1;
+    }
+}
+
+// shared.userdata[0] = fault function
+// shared.userdata[1] = chunk size
+// data.userdata[0] = mapping kept by FAULT-REFAULT
+// data.userdata[1] = worker stats
+
+static void fault_prepare(struct mt_data *data)
+{
+    const struct fault_function *function = (const struct fault_function *)data->shared->userdata[0];
+    size_t chunk = (size_t)data->shared->userdata[1];
+    void *memory = NULL;
+
+    if (function->kind == FAULT_REFAULT)
+    {
+        memory = mmap(NULL, chunk, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            perror("mmap");
+            abort();
+        }
+        madvise(memory, chunk, MADV_NOHUGEPAGE);
+        fault_touch((uint8_t *)memory, chunk);
+    }
+    data->userdata[0] = (uintptr_t)memory;
+    data->userdata[1] = (uintptr_t)calloc(1, sizeof(struct fault_stats));
+}
+
+static void fault_clean(struct mt_data *data)
+{
+    struct fault_stats *stats = (struct fault_stats *)data->userdata[1];
+    struct fault_stats *total = &fault_totals[data->shared->workers];
+
+    if (data->userdata[0])
+    {
+        munmap((void *)data->userdata[0], (size_t)data->shared->userdata[1]);
+    }
+    __atomic_add_fetch(&total->bytes, stats->bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->faults, stats->faults, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->map_ns, stats->map_ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->touch_ns, stats->touch_ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->unmap_ns, stats->unmap_ns, __ATOMIC_RELAXED);
+    free(stats);
+}
+
+static void fault_run(struct mt_data *data, struct fault_stats *stats)
+{
+    const struct fault_function *function = (const struct fault_function *)data->shared->userdata[0];
+    size_t chunk = (size_t)data->shared->userdata[1];
+    size_t length = function->kind == FAULT_THP ? chunk + FAULT_HUGE_PAGE : chunk;
+    uint64_t faults = fault_thread_faults();
+    uint64_t t0 = test_now_ns(), t1, t2;
+    uint8_t *base, *memory;
+
+    if (function->kind == FAULT_REFAULT)
+    {
+        base = memory = (uint8_t *)data->userdata[0];
+        madvise(memory, chunk, MADV_DONTNEED);
+    }
+    else
+    {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | (function->kind == FAULT_POPULATE ? MAP_POPULATE : 0);
+        base = (uint8_t *)mmap(NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            perror("mmap");
+            abort();
+        }
+        memory = base;
+        if (function->kind == FAULT_THP)
+        {
+            memory = (uint8_t *)(((uintptr_t)base + FAULT_HUGE_PAGE - 1) & ~(FAULT_HUGE_PAGE - 1));
+            madvise(memory, chunk, MADV_HUGEPAGE);
+        }
+        else if (function->kind == FAULT_4K)
+        {
+            madvise(memory, chunk, MADV_NOHUGEPAGE);
+        }
+    }
+    t1 = test_now_ns();
+    fault_touch(memory, chunk);
+    t2 = test_now_ns();
+    if (function->kind != FAULT_REFAULT)
+    {
+        munmap(base, length);
+    }
+
+    if (stats)
+    {
+        // the madvise of FAULT-REFAULT counts as its unmap
+        uint64_t t3 = test_now_ns();
+        stats->bytes += chunk;
+        stats->faults += fault_thread_faults() - faults;
+        stats->map_ns += function->kind == FAULT_REFAULT ? 0 : t1 - t0;
+        stats->touch_ns += t2 - t1;
+        stats->unmap_ns += function->kind == FAULT_REFAULT ? t1 - t0 : t3 - t2;
+    }
+}
+
+static void fault_warmup(struct mt_data *data)
+{
+    fault_run(data, NULL);
+}
+
+static void fault_test(struct mt_data *data)
+{
+    // calls of the adaptive warm-up are outside the window the rate is measured over, and the
+    // 1-worker reference run of -s would add to the totals of 1 worker
+    struct mt_shared *shared = data->shared;
+    int record = shared->measure_flag && !shared->serial_flag;
+
+    fault_run(data, record ? (struct fault_stats *)data->userdata[1] : NULL);
+    mt_counter_add(data, (size_t)data->shared->userdata[1]);
+}
+
+static struct mt_test_ops fault_ops = {
+    .prepare = fault_prepare,
+    .clean = fault_clean,
+    .warmup = fault_warmup,
+    .test = fault_test,
+    .unit = "byte",
+};
+
+static double do_fault_test(const void *arg, unsigned int tasks, struct mt_result *result)
+{
+    const struct test_case *tc = (const struct test_case *)arg;
+    size_t chunk = (test_mem_size / tasks) & ~(FAULT_HUGE_PAGE - 1);
+    uintptr_t userdata[2];
+    double r;
+
+    if (chunk > FAULT_CHUNK)
+    {
+        chunk = FAULT_CHUNK;
+    }
+    if (!chunk)
+    {
+        chunk = FAULT_HUGE_PAGE;
+    }
+    if (tc->size)
+    {
+        chunk = tc->size;
+    }
+    userdata[0] = (uintptr_t)tc->function;
+    userdata[1] = (uintptr_t)chunk;
+    r = mt_pool_run(test_pool, &fault_ops, tasks, test_duration, userdata, sizeof(userdata) / sizeof(userdata[0]), result);
+
+    // bytes per second to MB/s
+    return r / 1024 / 1024;
+}
+
+// run the fault functions whose name starts with the first len characters of prefix, "FAULT"
+// runs all of them, size replaces the chunk if not 0, then print for every thread count the
+// faults per second and where the time of a call goes
+static void run_fault_functions(const char *prefix, size_t len, size_t size)
+{
+    const unsigned int *threads;
+    unsigned int thread_count = mt_thread_counts(&threads);
+    size_t count = sizeof(fault_functions) / sizeof(fault_functions[0]);
+    const char *cols[] = {"MB/s", "Kfaults/s", "map us/MB", "touch us/MB", "unmap us/MB"};
+    const size_t col_count = sizeof(cols) / sizeof(cols[0]);
+    char (*names)[80] = (char (*)[80])malloc(sizeof(*names) * count * thread_count);
+    const char **rows = (const char **)malloc(sizeof(char *) * count * thread_count);
+    double *values = (double *)malloc(sizeof(double) * count * thread_count * col_count);
+    double *rates = (double *)malloc(sizeof(double) * thread_count);
+    unsigned int row_count = 0;
+    char base[64];
+
+    fault_totals = (struct fault_stats *)calloc(test_threads + 1, sizeof(struct fault_stats));
+    for (size_t j = 0; j < count; j++)
+    {
+        const struct fault_function *function = &fault_functions[j];
+        struct test_case tc = {function, size};
+        char name[64];
+
+        if (strncasecmp(function->name, prefix, len) != 0 || (function->name[len] && function->name[len] != '-'))
+        {
+            continue;
+        }
+        if (size)
+        {
+            size_case_name(name, sizeof(name), function->name, size);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%s", function->name);
+        }
+        memset(fault_totals, 0, sizeof(struct fault_stats) * (test_threads + 1));
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            rates[t] = mt_run_case_at(name, do_fault_test, &tc, 1.0 / 1024 / 1024, threads[t]);
+        }
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            const struct fault_stats *total = &fault_totals[threads[t]];
+            double mb = total->bytes / 1024.0 / 1024;
+            double *row = &values[row_count * col_count];
+
+            snprintf(names[row_count], sizeof(names[row_count]), "%s:%u", name, threads[t]);
+            rows[row_count] = names[row_count];
+            row[0] = rates[t];
+            row[1] = total->bytes ? rates[t] * 1024 * 1024 * total->faults / total->bytes / 1000 : 0;
+            row[2] = mb > 0 ? total->map_ns / 1000.0 / mb : 0;
+            row[3] = mb > 0 ? total->touch_ns / 1000.0 / mb : 0;
+            row[4] = mb > 0 ? total->unmap_ns / 1000.0 / mb : 0;
+            row_count++;
+        }
+    }
+    snprintf(base, sizeof(base), "%.*s", (int)len, prefix);
+    mt_report_matrix(base, "page faults", "per thread count", rows, row_count, cols, col_count, values);
+
+    free(fault_totals);
+    fault_totals = NULL;
+    free(names);
+    free(rows);
+    free(values);
+    free(rates);
+}
+
+// find the fault cases of name, "FAULT", "FAULT-4K" or "FAULT-4K/64K", return the length of the
+// name without the size or 0 if no case matches, size 0 if not given
+static size_t lookup_fault_function(const char *name, size_t *size)
+{
+    size_t len;
+
+    if (strncasecmp(name, "FAULT", 5) != 0)
+    {
+        return 0;
+    }
+    len = parse_case_name(name, size);
+    for (size_t j = 0; j < sizeof(fault_functions) / sizeof(fault_functions[0]); j++)
+    {
+        const char *candidate = fault_functions[j].name;
+        if (strncasecmp(candidate, name, len) == 0 && (candidate[len] == 0 || candidate[len] == '-'))
+        {
+            return len;
+        }
+    }
+    return 0;
+}
+
+// C2C bounces one cache line between the calling thread pinned to one cpu and a responder pinned
+// to another, every round trip hands the line over twice
+// round trips per sample, a few ms per pair even across sockets
+#define C2C_ROUNDS 20000
+#define C2C_SAMPLES 5
+
+struct c2c_pair
+{
+    uint64_t flag __attribute__((aligned(MT_CACHELINE_SIZE)));
+    int cpu __attribute__((aligned(MT_CACHELINE_SIZE)));
+    int cas;
+    uint64_t rounds;
+};
+
+static void c2c_pin(int cpu)
+{
+    cpu_set_t set;
+    int err;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+    if (err)
+    {
+        fprintf(stderr, "Cannot run on cpu %d: %s\n", cpu, strerror(err));
+        exit(EXIT_FAILURE);
+    }
+}
+
+// wait until flag holds wait, then hand the line over by writing set
+static void c2c_handoff(uint64_t *flag, uint64_t wait, uint64_t set, int cas)
+{
+    if (cas)
+    {
+        uint64_t expected = wait;
+        while (!__atomic_compare_exchange_n(flag, &expected, set, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            expected = wait;
+            mt_cpu_relax();
+        }
+        return;
+    }
+    while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) != wait)
+    {
+        mt_cpu_relax();
+    }
+    __atomic_store_n(flag, set, __ATOMIC_RELEASE);
+}
+
+static void *c2c_responder(void *arg)
+{
+    struct c2c_pair *pair = (struct c2c_pair *)arg;
+
+    c2c_pin(pair->cpu);
+    for (uint64_t r = 0; r < pair->rounds; r++)
+    {
+        c2c_handoff(&pair->flag, 2 * r + 1, 2 * r + 2, pair->cas);
+    }
+    return NULL;
+}
+
+// median round trip in ns between the calling thread on cpu a and a responder on cpu b
+static double c2c_round_trip(int a, int b, int cas)
+{
+    struct c2c_pair *pair;
+    pthread_t thread;
+    double samples[C2C_SAMPLES];
+    struct mt_stats stats;
+    uint64_t r = 0;
+
+    if (posix_memalign((void **)&pair, MT_CACHELINE_SIZE, sizeof(struct c2c_pair)))
+    {
+        abort();
+    }
+    memset(pair, 0, sizeof(struct c2c_pair));
+    pair->cpu = b;
+    pair->cas = cas;
+    pair->rounds = (C2C_SAMPLES + 1) * C2C_ROUNDS;
+    c2c_pin(a);
+    pthread_create(&thread, NULL, c2c_responder, pair);
+
+    // the first block warms up both cpus and is not timed
+    for (unsigned int s = 0; s <= C2C_SAMPLES; s++)
+    {
+        uint64_t start = test_now_ns();
+        for (uint64_t end = r + C2C_ROUNDS; r < end; r++)
+        {
+            c2c_handoff(&pair->flag, 2 * r, 2 * r + 1, cas);
+        }
+        // the last reply of the block
+        while (__atomic_load_n(&pair->flag, __ATOMIC_ACQUIRE) != 2 * r)
+        {
+            mt_cpu_relax();
+        }
+        if (s)
+        {
+            samples[s - 1] = (double)(test_now_ns() - start) / C2C_ROUNDS;
+        }
+    }
+    pthread_join(thread, NULL);
+    free(pair);
+    mt_stats_compute(samples, C2C_SAMPLES, &stats);
+    return stats.median;
+}
+
+// round trip latency between every pair of cpus this process may use, the median of -r runs
+// per pair, the cpus come from the affinity mask and not from -p
+static void run_c2c_matrix(const char *name, int cas)
+{
+    cpu_set_t allowed, saved;
+    int *cpus;
+    unsigned int count = 0;
+    unsigned int runs = mt_run_count();
+    char (*names)[16];
+    const char **labels;
+    double *values;
+    double *samples;
+    struct mt_stats stats;
+
+    if (mt_placed())
+    {
+        fprintf(stderr, "%s pins its own threads, -p does not apply, restrict the cpus with taskset\n", name);
+        exit(EXIT_FAILURE);
+    }
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        perror("sched_getaffinity");
+        abort();
+    }
+    if (CPU_COUNT(&allowed) < 2)
+    {
+        fprintf(stderr, "%s needs at least 2 cpus\n", name);
+        exit(EXIT_FAILURE);
+    }
+    cpus = (int *)malloc(sizeof(int) * CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+        {
+            cpus[count++] = cpu;
+        }
+    }
+    names = (char (*)[16])malloc(sizeof(*names) * count);
+    labels = (const char **)malloc(sizeof(char *) * count);
+    values = (double *)calloc(count * count, sizeof(double));
+    samples = (double *)malloc(sizeof(double) * runs);
+    pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "cpu%d", cpus[i]);
+        labels[i] = names[i];
+        for (unsigned int j = i + 1; j < count; j++)
+        {
+            for (unsigned int r = 0; r < runs; r++)
+            {
+                samples[r] = c2c_round_trip(cpus[i], cpus[j], cas);
+            }
+            mt_stats_compute(samples, runs, &stats);
+            values[i * count + j] = stats.median;
+            values[j * count + i] = values[i * count + j];
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+
+    mt_report_matrix_cells(name, "round trip", "ns", labels, count, labels, count, values);
+    free(samples);
+    free(cpus);
+    free(names);
+    free(labels);
+    free(values);
+}
+
+#define NUMA_MAX_NODES 64
+// latency working set, larger than the last level cache of current parts
+#define NUMA_LATENCY_SIZE (1ull << 30)
+
+// LOAD bandwidth with every -T worker and LATENCY of one worker for each pair of a node with cpus
+// and a node with memory, plus memory interleaved over all nodes
+static void run_numa_matrix(void)
+{
+    int cpu_nodes[NUMA_MAX_NODES], mem_nodes[NUMA_MAX_NODES];
+    unsigned int cpu_count = mt_numa_nodes(cpu_nodes, NUMA_MAX_NODES, 1);
+    unsigned int mem_count = mt_numa_nodes(mem_nodes, NUMA_MAX_NODES, 0);
+    unsigned int cols = mem_count + 1;
+    size_t latency_size = test_mem_size & ~(size_t)(SWEEP_MIN_SIZE - 1);
+    char row_names[NUMA_MAX_NODES][16], col_names[NUMA_MAX_NODES + 1][16];
+    const char *rows[NUMA_MAX_NODES], *col_list[NUMA_MAX_NODES + 1];
+    double *bandwidth, *latency;
+    char name[64];
+    size_t size;
+    struct test_case load = {lookup_memory_function("LOAD", &size), 0};
+    struct test_case chase = {lookup_latency_function("LATENCY", &size), 0};
+
+    if (!cpu_count || !mem_count)
+    {
+        fprintf(stderr, "NUMA-MATRIX needs libnuma and numa nodes\n");
+        exit(EXIT_FAILURE);
+    }
+    chase.size = latency_size < NUMA_LATENCY_SIZE ? latency_size : NUMA_LATENCY_SIZE;
+    for (unsigned int r = 0; r < cpu_count; r++)
+    {
+        snprintf(row_names[r], sizeof(row_names[r]), "cpu node%d", cpu_nodes[r]);
+        rows[r] = row_names[r];
+    }
+    for (unsigned int c = 0; c < cols; c++)
+    {
+        if (c < mem_count)
+        {
+            snprintf(col_names[c], sizeof(col_names[c]), "mem node%d", mem_nodes[c]);
+        }
+        else
+        {
+            snprintf(col_names[c], sizeof(col_names[c]), "interleave");
+        }
+        col_list[c] = col_names[c];
+    }
+
+    bandwidth = (double *)malloc(sizeof(double) * cpu_count * cols);
+    latency = (double *)malloc(sizeof(double) * cpu_count * cols);
+    for (unsigned int r = 0; r < cpu_count; r++)
+    {
+        for (unsigned int c = 0; c < cols; c++)
+        {
+            char mem[16];
+
+            test_cpu_node = cpu_nodes[r];
+            test_mem_node = c < mem_count ? mem_nodes[c] : TEST_NODE_INTERLEAVE;
+            if (c < mem_count)
+            {
+                snprintf(mem, sizeof(mem), "%d", mem_nodes[c]);
+            }
+            else
+            {
+                snprintf(mem, sizeof(mem), "I");
+            }
+            snprintf(name, sizeof(name), "NUMA-LOAD-C%dM%s", cpu_nodes[r], mem);
+            bandwidth[r * cols + c] = mt_run_case_at(name, do_memory_test, &load, 1.0 / 1024 / 1024, test_threads);
+            snprintf(name, sizeof(name), "NUMA-LATENCY-C%dM%s", cpu_nodes[r], mem);
+            latency[r * cols + c] = latency_ns(mt_run_case_at(name, do_latency_test, &chase, 1.0, 1), 1);
+        }
+    }
+    test_cpu_node = -1;
+    test_mem_node = TEST_NODE_DEFAULT;
+
+    mt_report_matrix("NUMA-MATRIX", "bandwidth", "MB/s", rows, cpu_count, col_list, cols, bandwidth);
+    mt_report_matrix("NUMA-MATRIX", "latency", "ns/load", rows, cpu_count, col_list, cols, latency);
+    free(bandwidth);
+    free(latency);
+}
+
+// one LATENCY worker next to the other workers reading memory with an injection delay, one point
+// of the latency against bandwidth curve for every delay, the bandwidth side runs memtest_ops
+// on the rest of the largest -T count, smaller counts of a -T list are not run
+static void run_loaded_latency(void)
+{
+    size_t per_thread_size = (test_mem_size / test_threads) & ~(size_t)(SWEEP_MIN_SIZE - 1);
+    size_t chase_size = per_thread_size < NUMA_LATENCY_SIZE ? per_thread_size : NUMA_LATENCY_SIZE;
+    struct mt_group groups[2];
+    const char *cols[] = {"MB/s", "ns/load"};
+    char (*names)[32] = (char (*)[32])malloc(sizeof(*names) * test_delay_count);
+    const char **rows = (const char **)malloc(sizeof(char *) * test_delay_count);
+    double *values = (double *)malloc(sizeof(double) * 2 * test_delay_count);
+    double rates[2];
+
+    if (test_threads < 2)
+    {
+        fprintf(stderr, "LOADED needs -T 2 or more, one worker chases pointers\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(groups, 0, sizeof(groups));
+    groups[0].name = (char *)"LATENCY";
+    groups[0].ops = &latency_ops;
+    groups[0].userdata[0] = LATENCY_RANDOM;
+    groups[0].userdata[1] = (uintptr_t)chase_size;
+    groups[0].userdata_count = 2;
+    groups[0].workers = 1;
+    groups[0].scale = 1.0;
+    groups[1].name = (char *)"LOAD";
+    groups[1].ops = &memtest_ops;
+    groups[1].userdata[0] = (uintptr_t)test_load_delay;
+    groups[1].userdata[1] = (uintptr_t)(per_thread_size & ~0x1ff);
+    groups[1].userdata_count = 2;
+    groups[1].workers = test_threads - 1;
+    groups[1].scale = 1.0 / 1024 / 1024;
+
+    for (size_t i = 0; i < test_delay_count; i++)
+    {
+        test_inject_delay = test_delay_list[i];
+        mt_run_together(test_pool, groups, 2, test_duration, rates);
+        snprintf(names[i], sizeof(names[i]), "delay %u", test_delay_list[i]);
+        rows[i] = names[i];
+        values[i * 2] = rates[1];
+        values[i * 2 + 1] = latency_ns(rates[0], 1);
+    }
+    test_inject_delay = 0;
+    mt_report_matrix_cells("LOADED", "latency against bandwidth", "per delay", rows,
+                           (unsigned int)test_delay_count, cols, 2, values);
+    free(names);
+    free(rows);
+    free(values);
+}
+
+static int lookup_test_function(const char *name, struct mt_group *group)
+{
+    const struct test_function *function;
+    const struct stream_function *stream;
+    const struct latency_function *latency;
+    const struct cpu_case *cpu;
+    size_t size;
+
+    if ((function = lookup_memory_function(name, &size)) != NULL)
+    {
+        group->ops = &memtest_ops;
+        group->userdata[0] = (uintptr_t)function->func;
+        group->userdata[1] = (uintptr_t)(size ? size : (test_mem_size / test_threads) & ~0x1ff);
+        group->userdata_count = 2;
+        group->scale = 1.0 / 1024 / 1024;
+        return 0;
+    }
+    if ((stream = lookup_stream_function(name, &size)) != NULL)
+    {
+        group->ops = &stream_ops;
+        group->userdata[0] = (uintptr_t)stream;
+        group->userdata[1] = (uintptr_t)(size ? size : (test_mem_size / test_threads) & ~0x1ff);
+        group->userdata_count = 2;
+        group->scale = STREAM_MB_SCALE;
+        return 0;
+    }
+    if ((latency = lookup_latency_function(name, &size)) != NULL)
+    {
+        group->ops = &latency_ops;
+        group->userdata[0] = (uintptr_t)latency->order;
+        group->userdata[1] = (uintptr_t)(size ? size : sweep_max_size());
+        group->userdata_count = 2;
+        group->scale = 1.0;
+        return 0;
+    }
+    // a compute tenant next to the memory ones, its rate stays in calls per second
+    if ((cpu = cpu_case_lookup(name)) != NULL)
+    {
+        cpu_case_group(cpu, group);
+        return 0;
+    }
+    return -1;
+}
+
+// cases joined with '+' run at the same time on separate workers
+static void run_test_mix(const char *cases)
+{
+    struct mt_group *groups;
+    unsigned int count = mt_parse_mix(cases, test_threads, lookup_test_function, &groups);
+
+    if (!count)
+    {
+        exit(EXIT_FAILURE);
+    }
+    mt_run_mix(cases, test_pool, groups, count, test_duration);
+    mt_mix_free(groups, count);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t function_count = sizeof(test_functions) / sizeof(test_functions[0]);
+
+    parse_args(argc, argv);
+    test_pool = mt_pool_new(test_threads);
+    test_mem_size = 1024ull * 1024ull * 1024ull * test_gb;
+
+    if (!test_quiet && mt_output_text())
+    {
+        printf("MAGIC_NOT_ZERO=%d test_gb=%u\n", MAGIC_NOT_ZERO, test_gb);
+        printf("TEST                Rate(MB/s), LATENCY loads/s\n");
+    }
+    if (test_case_count > 0)
+    {
+        for (size_t i = 0; i < test_case_count; i++)
+        {
+            const struct test_function *function;
+            const struct stream_function *stream;
+            const struct latency_function *latency;
+            char prefix[32];
+            size_t size, len;
+
+            if (strchr(test_case_list[i], '+'))
+            {
+                run_test_mix(test_case_list[i]);
+                continue;
+            }
+            if (strcasecmp(test_case_list[i], "SIMD") == 0)
+            {
+                run_simd_report();
+            }
+            else if (strcasecmp(test_case_list[i], "C2C") == 0 || strcasecmp(test_case_list[i], "C2C-CAS") == 0)
+            {
+                run_c2c_matrix(strcasecmp(test_case_list[i], "C2C") ? "C2C-CAS" : "C2C",
+                               strcasecmp(test_case_list[i], "C2C") != 0);
+            }
+            else if (strcasecmp(test_case_list[i], "STREAM") == 0)
+            {
+                for (size_t j = 0; j < sizeof(stream_functions) / sizeof(stream_functions[0]); j++)
+                {
+                    run_stream_function(&stream_functions[j], 0);
+                }
+            }
+            else if (strcasecmp(test_case_list[i], "LOADED") == 0)
+            {
+                run_loaded_latency();
+            }
+            else if (strcasecmp(test_case_list[i], "NUMA-MATRIX") == 0)
+            {
+                run_numa_matrix();
+            }
+            else if ((len = lookup_fault_function(test_case_list[i], &size)) != 0)
+            {
+                run_fault_functions(test_case_list[i], len, size);
+            }
+            else if ((function = lookup_memory_function(test_case_list[i], &size)) != NULL)
+            {
+                run_test_function(function, size);
+            }
+            else if ((stream = lookup_stream_function(test_case_list[i], &size)) != NULL)
+            {
+                run_stream_function(stream, size);
+            }
+            else if ((latency = lookup_latency_function(test_case_list[i], &size)) != NULL)
+            {
+                run_latency_function(latency, size);
+            }
+            else if (lookup_pattern_function(test_case_list[i], prefix, sizeof(prefix), &size))
+            {
+                run_pattern_functions(prefix, size);
+            }
+            else
+            {
+                fprintf(stderr, "Unknown test case: %s\n", test_case_list[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < function_count; i++)
+        {
+            run_test_function(&test_functions[i], 0);
+        }
+    }
+
+    mt_pool_delete(test_pool);
 }
@@ -18,6 +18,7 @@ static unsigned int test_threads;
 
 static size_t test_case_count;
 static char **test_case_list;
+static struct mt_pool *test_pool;
 
 static void usage(FILE *f)
 {
@@ -26,15 +27,17 @@ static void usage(FILE *f)
                 "  -h            print this help\n"
                 "  -q            print less information\n"
                 "  -t <duration> Specify the duration to test\n"
-                "  -T <threads>  Specify the number of threads to test\n"
+                "  -T <threads>  Specify the number of threads to test, a list like 1,2,4 or 1..N\n"
+                "                runs every count and reports speedup and scaling fits\n"
                 ""
             );
+    mt_usage_opts(f);
 }
 
 static void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hqt:T:")) != -1)
+    while ((opt = getopt(argc, argv, "hqt:T:" MT_OPTSTRING)) != -1)
     {
         switch (opt)
         {
@@ -48,9 +51,13 @@ static void parse_args(int argc, char *argv[])
             test_duration = atoi(optarg);
             break;
         case 'T':
-            test_threads = atoi(optarg);
+            test_threads = mt_parse_threads(optarg);
             break;
         default:
+            if (mt_parse_opt(opt, optarg))
+            {
+                break;
+            }
             usage(stderr);
             exit(EXIT_FAILURE);
         }
@@ -122,37 +129,41 @@ static void ssl_md_test(struct mt_data *data)
 }
 
 
-static double do_ssl_md_test(const char *md_name, size_t block_size)
+static struct mt_test_ops ssl_md_ops = {
+    .prepare = ssl_md_parpare,
+    .clean = ssl_md_clean,
+    .warmup = ssl_md_test,
+    .test = ssl_md_test,
+};
+
+static const EVP_MD *get_digest(const char *md_name)
 {
-    static struct mt_test_ops ssl_md_ops = {
-        .prepare = ssl_md_parpare,
-        .clean = ssl_md_clean,
-        .warmup = ssl_md_test,
-        .test = ssl_md_test,
-    };
     const EVP_MD *md = EVP_get_digestbyname(md_name);
     if (md == NULL)
     {
         fprintf(stderr, "EVP_get_digestbyname(%s) failed\n", md_name);
         abort();
     }
+    return md;
+}
+
+static double do_ssl_md_test(const char *md_name, size_t block_size, unsigned int tasks, struct mt_result *result)
+{
+    const EVP_MD *md = get_digest(md_name);
 
     struct mt_shared shared;
     mt_shared_init(&shared);
     shared.ops = &ssl_md_ops;
     shared.userdata[0] = (uintptr_t)md;
     shared.userdata[1] = (uintptr_t)block_size;
+    shared.result = result;
+    shared.pool = test_pool;
 
-    struct mt_data *data_list = (struct mt_data *)malloc(sizeof(struct mt_data) * test_threads);
-    memset(data_list, 0, sizeof(struct mt_data) * test_threads);
-
-    for (size_t i = 0; i < test_threads; i++)
-    {
-        data_list[i].shared = &shared;
-    }
+    struct mt_data *data_list = mt_data_new(&shared, tasks);
 
-    double r = mt_run_all(data_list, test_threads, test_duration);
-    free(data_list);
+    double r = mt_run_all(data_list, tasks, test_duration);
+    mt_data_delete(data_list);
+    mt_shared_destroy(&shared);
     return r;
 }
 
@@ -171,12 +182,53 @@ static struct test_function test_functions[] = {
     {"SM3-8K",      "sm3",      8192},
 };
 
+static double run_test_once(const void *arg, unsigned int tasks, struct mt_result *result)
+{
+    const struct test_function *function = (const struct test_function *)arg;
+    return do_ssl_md_test(function->alg_name, function->block_size, tasks, result);
+}
+
+static void run_test_function(const struct test_function *function)
+{
+    mt_run_case(function->test_name, run_test_once, function, 1.0);
+}
+
+static int lookup_test_function(const char *name, struct mt_group *group)
+{
+    for (size_t j = 0; j < sizeof(test_functions) / sizeof(test_functions[0]); j++)
+    {
+        if (strcasecmp(name, test_functions[j].test_name) == 0)
+        {
+            group->ops = &ssl_md_ops;
+            group->userdata[0] = (uintptr_t)get_digest(test_functions[j].alg_name);
+            group->userdata[1] = (uintptr_t)test_functions[j].block_size;
+            group->userdata_count = 2;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// cases joined with '+' run at the same time on separate workers
+static void run_test_mix(const char *cases)
+{
+    struct mt_group *groups;
+    unsigned int count = mt_parse_mix(cases, test_threads, lookup_test_function, &groups);
+
+    if (!count)
+    {
+        exit(EXIT_FAILURE);
+    }
+    mt_run_mix(cases, test_pool, groups, count, test_duration);
+    mt_mix_free(groups, count);
+}
+
 int main(int argc, char *argv[])
 {
-    double r;
     parse_args(argc, argv);
+    test_pool = mt_pool_new(test_threads);
 
-    if (!test_quiet)
+    if (!test_quiet && mt_output_text())
     {
         printf("TEST                Rate(ops/s)\n");
     }
@@ -186,12 +238,16 @@ int main(int argc, char *argv[])
         for (size_t i = 0; i < test_case_count; i++)
         {
             size_t j;
+            if (strchr(test_case_list[i], '+'))
+            {
+                run_test_mix(test_case_list[i]);
+                continue;
+            }
             for (j = 0; j < sizeof(test_functions) / sizeof(test_functions[0]); j++)
             {
                 if (strcasecmp(test_case_list[i], test_functions[j].test_name) == 0)
                 {
-                    r = do_ssl_md_test(test_functions[j].alg_name, test_functions[j].block_size);
-                    printf("%-20s%.2f\n", test_functions[j].test_name, r);
+                    run_test_function(&test_functions[j]);
                     break;
                 }
             }
@@ -206,10 +262,10 @@ int main(int argc, char *argv[])
     {
         for (size_t i = 0; i < sizeof(test_functions) / sizeof(test_functions[0]); i++)
         {
-            r = do_ssl_md_test(test_functions[i].alg_name, test_functions[i].block_size);
-            printf("%-20s%.2f\n", test_functions[i].test_name, r);
+            run_test_function(&test_functions[i]);
         }
     }
 
+    mt_pool_delete(test_pool);
     return 0;
 }